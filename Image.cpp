@@ -1,8 +1,324 @@
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
 #include "Image.hpp"
+#include "mapped_file.hpp"
 
 using namespace std;
 
+// Position in PPM text held in memory, read by the scan_* functions.
+struct PpmScanner {
+  const char *pos;
+  const char *end;
+};
+
+// EFFECTS:  Returns whether ch is one of the whitespace characters that
+//           stream extraction skips.
+static bool is_space(char ch) {
+  return ch == ' ' || ('\t' <= ch && ch <= '\r');
+}
+
+// MODIFIES: *in
+// EFFECTS:  Skips any whitespace at the current position.
+static void skip_space(PpmScanner *in) {
+  while (in->pos < in->end && is_space(*in->pos)) {
+    ++in->pos;
+  }
+}
+
+// MODIFIES: *in
+// EFFECTS:  Reads and returns the next whitespace-delimited word.
+static string scan_word(PpmScanner *in) {
+  skip_space(in);
+  const char *start = in->pos;
+  while (in->pos < in->end && !is_space(*in->pos)) {
+    ++in->pos;
+  }
+  return string(start, in->pos);
+}
+
+// MODIFIES: *in
+// EFFECTS:  Reads and returns the next integer. Returns 0 without
+//           consuming anything if there is none, as a failed stream
+//           extraction stores 0.
+static int scan_int(PpmScanner *in) {
+  skip_space(in);
+  int value = 0;
+  from_chars_result result = from_chars(in->pos, in->end, value);
+  if (result.ec == errc()) {
+    in->pos = result.ptr;
+  }
+  return value;
+}
+
+// How P3 text is currently split between threads. By default, bodies
+// of at least 4 MiB are parsed in chunks of at least 1 MiB, and images
+// are printed in blocks of about 1 MiB.
+static TextParallelism text_parallelism = { 0, 1 << 22, 1 << 20, 1 << 20 };
+
+// EFFECTS:  Returns the current settings for splitting P3 text between
+//           threads.
+TextParallelism Image_text_parallelism() {
+  return text_parallelism;
+}
+
+// MODIFIES: the settings for splitting P3 text between threads
+// EFFECTS:  Replaces the settings with the given ones.
+void Image_set_text_parallelism(const TextParallelism &settings) {
+  text_parallelism = settings;
+}
+
+// EFFECTS:  Returns the most threads P3 text may be split between.
+static unsigned text_threads() {
+  if (text_parallelism.threads > 0) {
+    return text_parallelism.threads;
+  }
+  return max(thread::hardware_concurrency(), 1u);
+}
+
+// EFFECTS:  Returns the number of whitespace-delimited words in
+//           [begin, end).
+static long long count_words(const char *begin, const char *end) {
+  long long count = 0;
+  bool in_word = false;
+  for (const char *p = begin; p < end; ++p) {
+    bool space = is_space(*p);
+    count += !space && !in_word;
+    in_word = !space;
+  }
+  return count;
+}
+
+// Where parsed color values go: value v is stored at
+// planes[v % 3][v / 3 * step].
+struct ValueOutput {
+  uint8_t *planes[3];
+  int step;
+};
+
+// The words of [begin, end) in a P3 body, which are the color values
+// with indices first, first + 1, ..., up to but not including last.
+struct ValueChunk {
+  const char *begin;
+  const char *end;
+  long long first;
+  long long last;
+};
+
+// REQUIRES: out has room for the values first, ..., last - 1 of chunk
+// MODIFIES: the planes of out
+// EFFECTS:  Parses the words of the chunk as its color values and stores
+//           them in out, stopping at chunk.last. A word that is not a
+//           number reads as 0.
+static void parse_values(const ValueChunk &chunk, const ValueOutput &out) {
+  const char *p = chunk.begin;
+  const char *end = chunk.end;
+  long long pixel = chunk.first / 3;
+  int channel = chunk.first % 3;
+  for (long long v = chunk.first; v < chunk.last; ++v) {
+    while (p < end && is_space(*p)) {
+      ++p;
+    }
+    if (p == end) {
+      return;
+    }
+    // Digits are accumulated by hand so that each word is scanned once,
+    // whether or not it turns out to be a number.
+    unsigned value = 0;
+    bool number = true;
+    for (; p < end && !is_space(*p); ++p) {
+      unsigned digit = *p - '0';
+      number = number && digit < 10;
+      value = value * 10 + digit;
+    }
+    out.planes[channel][pixel * out.step] = number ? value : 0;
+    if (++channel == 3) {
+      channel = 0;
+      ++pixel;
+    }
+  }
+}
+
+// EFFECTS:  Runs task(0), ..., task(count - 1) concurrently, on the
+//           calling thread and count - 1 others, and waits for them all.
+template <typename Task>
+static void run_in_parallel(unsigned count, const Task &task) {
+  vector<thread> workers;
+  for (unsigned t = 1; t < count; ++t) {
+    workers.emplace_back(task, t);
+  }
+  task(0);
+  for (thread &worker : workers) {
+    worker.join();
+  }
+}
+
+// REQUIRES: body is the whole body of an ASCII PPM image, with first 0
+//           and last the number of color values, and out is as for
+//           parse_values
+// MODIFIES: the planes of out
+// EFFECTS:  Parses the body as parse_values does. Large bodies are split
+//           into one chunk per thread at whitespace, so no word is cut;
+//           the words of every chunk are counted in parallel, the counts
+//           are prefix-summed into the index of each chunk's first value,
+//           and then the chunks are parsed in parallel.
+static void parse_body(const ValueChunk &body, const ValueOutput &out) {
+  const char *begin = body.begin;
+  const char *end = body.end;
+  size_t size = end - begin;
+  size_t threads = text_threads();
+  threads = min(threads, size / max<size_t>(text_parallelism.parse_min_chunk, 1));
+  if (size < text_parallelism.parse_min_bytes || threads < 2) {
+    parse_values(body, out);
+    return;
+  }
+
+  vector<const char *> bounds(threads + 1);
+  bounds[0] = begin;
+  bounds[threads] = end;
+  for (size_t t = 1; t < threads; ++t) {
+    const char *p = max(begin + size * t / threads, bounds[t - 1]);
+    while (p < end && !is_space(*p)) {
+      ++p;
+    }
+    bounds[t] = p;
+  }
+
+  // firsts[t] is the index of the first value in chunk t.
+  vector<long long> firsts(threads + 1, 0);
+  run_in_parallel(threads, [&bounds, &firsts](unsigned t) {
+    firsts[t + 1] = count_words(bounds[t], bounds[t + 1]);
+  });
+  partial_sum(firsts.begin(), firsts.end(), firsts.begin());
+  run_in_parallel(threads, [&](unsigned t) {
+    ValueChunk chunk = { bounds[t], bounds[t + 1], firsts[t],
+                         min(firsts[t + 1], body.last) };
+    parse_values(chunk, out);
+  });
+}
+
+// REQUIRES: in holds an image in PPM format without comments
+// MODIFIES: *in
+// EFFECTS:  Reads the PPM header, checks it, and returns the dimensions
+//           through width and height. Returns whether the pixels that
+//           follow are binary (P6) rather than ASCII (P3), in which case
+//           in is left at the first pixel byte and holds all of them.
+static bool scan_header(PpmScanner *in, int *width, int *height) {
+  string magic = scan_word(in);
+  *width = scan_int(in);
+  *height = scan_int(in);
+  int maxVal = scan_int(in);
+
+  assert(magic == "P3" || magic == "P6");
+  assert(*width > 0);
+  assert(*height > 0);
+  assert(maxVal == 255);
+
+  if (magic != "P6") {
+    return false;
+  }
+  // A single whitespace character separates a binary raster from the
+  // header, and the raster may start with bytes that look like more.
+  ++in->pos;
+  assert(in->end - in->pos >= 3LL * *width * *height);
+  return true;
+}
+
+// EFFECTS:  Returns the most bytes of P3 text a row of the given width
+//           can take: three values of up to three digits and a space
+//           per pixel, and a newline.
+static size_t max_row_text(int width) {
+  return 12 * (size_t)width + 1;
+}
+
+// REQUIRES: out has room for 4 bytes
+// EFFECTS:  Writes value followed by a space at out and returns the end.
+static char *put_value(char *out, uint8_t value) {
+  out = to_chars(out, out + 3, value).ptr;
+  *out++ = ' ';
+  return out;
+}
+
+// REQUIRES: img points to a valid Image
+//           0 <= begin <= end <= Image_height(img)
+//           out has room for (end - begin) * max_row_text(width) bytes
+// EFFECTS:  Writes rows [begin, end) of img at out as Image_print formats
+//           them and returns the end of the text.
+static char *format_rows(const Image *img, int begin, int end, char *out) {
+  for (int i = begin; i < end; ++i) {
+    ImageRow<const uint8_t> row = Image_row(img, i);
+    for (int j = 0; j < img->width; ++j) {
+      out = put_value(out, row.red[j]);
+      out = put_value(out, row.green[j]);
+      out = put_value(out, row.blue[j]);
+    }
+    *out++ = '\n';
+  }
+  return out;
+}
+
+// EFFECTS:  Same as format_rows for an Image.
+static char *format_rows(const PackedImage *img, int begin, int end,
+                         char *out) {
+  const uint8_t *in = img->data.data() + 3LL * img->width * begin;
+  for (int i = begin; i < end; ++i) {
+    for (int j = 0; j < 3 * img->width; ++j) {
+      out = put_value(out, *in++);
+    }
+    *out++ = '\n';
+  }
+  return out;
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: os
+// EFFECTS:  Writes the image to os in the P3 format Image_print
+//           specifies. The rows are split into blocks of about
+//           print_block bytes of text, and each thread formats every
+//           threads-th block into its own buffer and writes it out when
+//           the blocks before it have been written.
+template <typename Img>
+static void print_text(const Img *img, std::ostream &os) {
+  int width = Image_width(img);
+  int height = Image_height(img);
+  os << "P3\n" << width << " " << height << "\n" << MAX_INTENSITY << "\n";
+
+  // A block never holds more rows than the image, so small images don't
+  // get a full print_block buffer per thread.
+  size_t block_bytes = text_parallelism.print_block;
+  int rows_per_block = max<size_t>(block_bytes / max_row_text(width), 1);
+  rows_per_block = min(rows_per_block, height);
+  int blocks = (height + rows_per_block - 1) / rows_per_block;
+  unsigned threads = min<unsigned>(text_threads(), blocks);
+
+  mutex lock;
+  condition_variable turn_changed;
+  int next_block = 0;
+  run_in_parallel(threads, [&](unsigned t) {
+    vector<char> buffer(rows_per_block * max_row_text(width));
+    for (int block = t; block < blocks; block += threads) {
+      int begin = block * rows_per_block;
+      int end = min(begin + rows_per_block, height);
+      size_t length = format_rows(img, begin, end, buffer.data()) -
+                      buffer.data();
+      unique_lock<mutex> hold(lock);
+      turn_changed.wait(hold, [&] { return next_block == block; });
+      os.write(buffer.data(), length);
+      ++next_block;
+      turn_changed.notify_all();
+    }
+  });
+  os.flush();
+}
+
 // REQUIRES: img points to an Image
 //           0 < width && 0 < height
 // MODIFIES: *img
@@ -24,33 +340,58 @@ Matrix_fill(&img -> blue_channel, 0);
 // REQUIRES: img points to an Image
 //           is contains an image in PPM format without comments
 //           (any kind of whitespace is ok)
-// MODIFIES: *img, is
+// MODIFIES: *img, is (which is read to its end, past the image)
 // EFFECTS:  Initializes the Image by reading in an image in PPM format
 //           from the given input stream.
 // NOTE:     See the project spec for a discussion of PPM format.
 void Image_init(Image* img, std::istream& is) {
-  string magic;
-  int width = 0, height = 0, maxVal = 0;
-  is >> magic >> width >> height >> maxVal;
-
-  assert(magic == "P3");
-  assert(width > 0);
-  assert(height > 0);
-  assert(maxVal == 255);
+  string text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+  Image_init(img, text.data(), text.size());
+}
 
+// REQUIRES: img points to an Image
+//           data points to size bytes holding an image in PPM format
+//           without comments (any kind of whitespace is ok)
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image by parsing the PPM text in memory,
+//           the same way Image_init(img, is) parses a stream.
+void Image_init(Image* img, const char* data, size_t size) {
+  PpmScanner in = { data, data + size };
+  int width, height;
+  bool binary = scan_header(&in, &width, &height);
   Image_init(img, width, height);
 
-  for (int i = 0; i < height; ++i) {
-    for (int j = 0; j < width; ++j) {
-      int r, g, b;
-      is >> r >> g >> b;
-      *Matrix_at(&img->red_channel, i, j) = r;
-      *Matrix_at(&img->green_channel, i, j) = g;
-      *Matrix_at(&img->blue_channel, i, j) = b;
-        }
+  uint8_t *red = img->red_channel.data.data();
+  uint8_t *green = img->green_channel.data.data();
+  uint8_t *blue = img->blue_channel.data.data();
+  long long count = (long long)width * height;
+  if (binary) {
+    const uint8_t *raster = reinterpret_cast<const uint8_t *>(in.pos);
+    for (long long i = 0; i < count; ++i) {
+      red[i] = raster[3 * i];
+      green[i] = raster[3 * i + 1];
+      blue[i] = raster[3 * i + 2];
     }
+    return;
+  }
+  ValueOutput out = { { red, green, blue }, 1 };
+  parse_body({ in.pos, in.end, 0, 3 * count }, out);
 }
 
+// REQUIRES: img points to an Image
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image from the PPM file with the given name,
+//           which is memory-mapped and parsed in place. Returns whether
+//           the file could be opened.
+bool Image_read(Image* img, const std::string& filename) {
+  MappedFile file;
+  if (!MappedFile_open(&file, filename)) {
+    return false;
+  }
+  Image_init(img, reinterpret_cast<const char*>(file.data), file.size);
+  MappedFile_close(&file);
+  return true;
+}
 
 // REQUIRES: img points to a valid Image
 // MODIFIES: os
@@ -67,18 +408,27 @@ void Image_init(Image* img, std::istream& is) {
 //           "extra" space at the end of each line. See the project spec
 //           for an example.
 void Image_print(const Image* img, std::ostream& os) {
-  os << "P3" << endl;
-  os << img->width << " " << img -> height << endl;
-  os << "255" << endl;
+  print_text(img, os);
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in binary PPM
+//           format: the header as Image_print writes it but with magic
+//           P6, followed by three bytes per pixel (red, green, blue) in
+//           row-major order with no separators.
+void Image_print_binary(const Image* img, std::ostream& os) {
+  os << "P6\n" << img->width << " " << img->height << "\n255\n";
 
+  vector<char> row(3 * img->width);
   for (int i = 0; i < img->height; ++i) {
+    ImageRow<const uint8_t> pixels = Image_row(img, i);
     for (int j = 0; j < img->width; ++j) {
-      int R = *Matrix_at(&img->red_channel, i, j);
-      int G = *Matrix_at(&img->green_channel, i, j);
-      int B = *Matrix_at(&img->blue_channel, i, j);
-      os << R << " " << G << " " << B << " ";
+      row[3 * j] = pixels.red[j];
+      row[3 * j + 1] = pixels.green[j];
+      row[3 * j + 2] = pixels.blue[j];
     }
-    os << endl;
+    os.write(row.data(), row.size());
   }
 }
 
@@ -99,10 +449,11 @@ int Image_height(const Image* img) {
 //           0 <= column && column < Image_width(img)
 // EFFECTS:  Returns the pixel in the Image at the given row and column.
 Pixel Image_get_pixel(const Image* img, int row, int column) {
+  ImageRow<const uint8_t> pixels = Image_row(img, row);
   Pixel p;
-  p.r = *Matrix_at(&img->red_channel, row, column);
-  p.g = *Matrix_at(&img->green_channel, row, column);
-  p.b = *Matrix_at(&img->blue_channel, row, column);
+  p.r = pixels.red[column];
+  p.g = pixels.green[column];
+  p.b = pixels.blue[column];
   return p;
 }
 
@@ -113,18 +464,231 @@ Pixel Image_get_pixel(const Image* img, int row, int column) {
 // EFFECTS:  Sets the pixel in the Image at the given row and column
 //           to the given color.
 void Image_set_pixel(Image* img, int row, int column, Pixel color) {
-  *Matrix_at(&img->red_channel, row, column)   = color.r;
-  *Matrix_at(&img->green_channel, row, column) = color.g;
-  *Matrix_at(&img->blue_channel, row, column)  = color.b;
+  ImageRow<uint8_t> pixels = Image_row(img, row);
+  pixels.red[column]   = color.r;
+  pixels.green[column] = color.g;
+  pixels.blue[column]  = color.b;
 }
 
 // REQUIRES: img points to a valid Image
 // MODIFIES: *img
 // EFFECTS:  Sets each pixel in the image to the given color.
 void Image_fill(Image* img, Pixel color) {
-  for (int i = 0; i < img->height; ++i) {
-    for (int j = 0; j < img->width; ++j) {
-      Image_set_pixel(img, i, j, color);
-    }
+  Matrix_fill(&img->red_channel, color.r);
+  Matrix_fill(&img->green_channel, color.g);
+  Matrix_fill(&img->blue_channel, color.b);
+}
+
+// REQUIRES: img points to a PackedImage
+//           0 < width && 0 < height
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage with the given width and height,
+//           with all pixels initialized to RGB values of 0.
+void Image_init(PackedImage* img, int width, int height) {
+  img->width = width;
+  img->height = height;
+  long long count = 3LL * (long long)width * (long long)height;
+  img->data.assign(count, 0);
+}
+
+// REQUIRES: img points to a PackedImage
+//           is contains an image in PPM format without comments
+//           (any kind of whitespace is ok)
+// MODIFIES: *img, is (which is read to its end, past the image)
+// EFFECTS:  Initializes the PackedImage by reading in an image in PPM
+//           format from the given input stream.
+void Image_init(PackedImage* img, std::istream& is) {
+  string text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+  Image_init(img, text.data(), text.size());
+}
+
+// REQUIRES: img points to a PackedImage
+//           data points to size bytes holding an image in PPM format
+//           without comments (any kind of whitespace is ok)
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage by parsing the PPM text in
+//           memory, the same way Image_init(img, is) parses a stream.
+void Image_init(PackedImage* img, const char* data, size_t size) {
+  PpmScanner in = { data, data + size };
+  int width, height;
+  bool binary = scan_header(&in, &width, &height);
+  Image_init(img, width, height);
+
+  if (binary) {
+    memcpy(img->data.data(), in.pos, img->data.size());
+    return;
+  }
+  uint8_t *pixels = img->data.data();
+  ValueOutput out = { { pixels, pixels + 1, pixels + 2 }, 3 };
+  parse_body({ in.pos, in.end, 0, (long long)img->data.size() }, out);
+}
+
+// REQUIRES: img points to a PackedImage
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage from the PPM file with the given
+//           name, which is memory-mapped and parsed in place. Returns
+//           whether the file could be opened.
+bool Image_read(PackedImage* img, const std::string& filename) {
+  MappedFile file;
+  if (!MappedFile_open(&file, filename)) {
+    return false;
   }
+  Image_init(img, reinterpret_cast<const char*>(file.data), file.size);
+  MappedFile_close(&file);
+  return true;
+}
+
+// REQUIRES: img points to a PackedImage
+//           src points to a valid Image
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage as a copy of the given Image.
+void Image_init(PackedImage* img, const Image* src) {
+  Image_init(img, src->width, src->height);
+  long long count = (long long)src->width * (long long)src->height;
+  uint8_t *out = img->data.data();
+  for (long long i = 0; i < count; ++i) {
+    out[3 * i] = src->red_channel.data[i];
+    out[3 * i + 1] = src->green_channel.data[i];
+    out[3 * i + 2] = src->blue_channel.data[i];
+  }
+}
+
+// REQUIRES: img points to an Image
+//           src points to a valid PackedImage
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image as a copy of the given PackedImage.
+void Image_init(Image* img, const PackedImage* src) {
+  Image_init(img, src->width, src->height);
+  long long count = (long long)src->width * (long long)src->height;
+  const uint8_t *in = src->data.data();
+  for (long long i = 0; i < count; ++i) {
+    img->red_channel.data[i] = in[3 * i];
+    img->green_channel.data[i] = in[3 * i + 1];
+    img->blue_channel.data[i] = in[3 * i + 2];
+  }
+}
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in PPM format,
+//           exactly as Image_print does for an Image.
+void Image_print(const PackedImage* img, std::ostream& os) {
+  print_text(img, os);
+}
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in binary PPM
+//           format, exactly as Image_print_binary does for an Image.
+void Image_print_binary(const PackedImage* img, std::ostream& os) {
+  os << "P6\n" << img->width << " " << img->height << "\n255\n";
+  os.write(reinterpret_cast<const char *>(img->data.data()),
+           img->data.size());
+}
+
+// REQUIRES: img points to a valid PackedImage
+// EFFECTS:  Returns the width of the PackedImage.
+int Image_width(const PackedImage* img) {
+  return img->width;
+}
+
+// REQUIRES: img points to a valid PackedImage
+// EFFECTS:  Returns the height of the PackedImage.
+int Image_height(const PackedImage* img) {
+  return img->height;
+}
+
+// REQUIRES: img points to a valid PackedImage
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// EFFECTS:  Returns the pixel in the PackedImage at the given row and
+//           column.
+Pixel Image_get_pixel(const PackedImage* img, int row, int column) {
+  long long index = 3 * ((long long)row * img->width + column);
+  const uint8_t *p = &img->data[index];
+  return Pixel{p[0], p[1], p[2]};
+}
+
+// REQUIRES: img points to a valid PackedImage
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// MODIFIES: *img
+// EFFECTS:  Sets the pixel in the PackedImage at the given row and column
+//           to the given color.
+void Image_set_pixel(PackedImage* img, int row, int column, Pixel color) {
+  long long index = 3 * ((long long)row * img->width + column);
+  uint8_t *p = &img->data[index];
+  p[0] = color.r;
+  p[1] = color.g;
+  p[2] = color.b;
+}
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: *img
+// EFFECTS:  Sets each pixel in the image to the given color.
+void Image_fill(PackedImage* img, Pixel color) {
+  for (size_t i = 0; i < img->data.size(); i += 3) {
+    img->data[i] = color.r;
+    img->data[i + 1] = color.g;
+    img->data[i + 2] = color.b;
+  }
+}
+
+// REQUIRES: view points to an ImageView
+//           0 < shape.width && 0 < shape.height
+//           data points to shape.height rows of 3 * shape.width bytes,
+//           each starting shape.stride bytes after the one before
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over the given pixels.
+void ImageView_init(ImageView* view, uint8_t* data, const ViewShape &shape) {
+  assert(0 < shape.width && 0 < shape.height);
+  assert(shape.stride >= 3 * (std::ptrdiff_t)shape.width);
+  view->width = shape.width;
+  view->height = shape.height;
+  view->stride = shape.stride;
+  view->data = data;
+}
+
+// REQUIRES: view points to an ImageView
+//           img points to a valid PackedImage
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over all pixels of the PackedImage.
+void ImageView_init(ImageView* view, PackedImage* img) {
+  ImageView_init(view, img->data.data(),
+                 { img->width, img->height, 3 * (std::ptrdiff_t)img->width });
+}
+
+// REQUIRES: img points to a valid ImageView
+// EFFECTS:  Returns the width of the viewed image.
+int Image_width(const ImageView* img) {
+  return img->width;
+}
+
+// REQUIRES: img points to a valid ImageView
+// EFFECTS:  Returns the height of the viewed image.
+int Image_height(const ImageView* img) {
+  return img->height;
+}
+
+// REQUIRES: img points to a valid ImageView
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// EFFECTS:  Returns the viewed pixel at the given row and column.
+Pixel Image_get_pixel(const ImageView* img, int row, int column) {
+  const uint8_t *p = img->data + row * img->stride + 3 * column;
+  return Pixel{p[0], p[1], p[2]};
+}
+
+// REQUIRES: img points to a valid ImageView
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// MODIFIES: the viewed pixels
+// EFFECTS:  Sets the viewed pixel at the given row and column to the
+//           given color.
+void Image_set_pixel(ImageView* img, int row, int column,
+                     Pixel color) {
+  uint8_t *p = img->data + row * img->stride + 3 * column;
+  p[0] = color.r;
+  p[1] = color.g;
+  p[2] = color.b;
 }
@@ -6,7 +6,9 @@
  * for the image processing project in EECS 280, Winter 2016.
  */
 
+#include <cstddef>
 #include <iostream>
+#include <string>
 #include "Matrix.hpp"
 
 // Representation of an RGB Pixel used for
@@ -21,13 +23,14 @@ struct Pixel {
 const int MAX_INTENSITY = 255;
 
 // Representation of 2D RGB image.
+// Each color channel stores one byte per pixel.
 // Image objects may be copied.
 struct Image {
   int width;
   int height;
-  Matrix red_channel;
-  Matrix green_channel;
-  Matrix blue_channel;
+  Matrix8 red_channel;
+  Matrix8 green_channel;
+  Matrix8 blue_channel;
 };
 
 // REQUIRES: img points to an Image
@@ -40,12 +43,52 @@ void Image_init(Image* img, int width, int height);
 // REQUIRES: img points to an Image
 //           is contains an image in PPM format without comments
 //           (any kind of whitespace is ok)
-// MODIFIES: *img, is
+// MODIFIES: *img, is (which is read to its end, past the image)
 // EFFECTS:  Initializes the Image by reading in an image in PPM format
 //           from the given input stream.
 // NOTE:     See the project spec for a discussion of PPM format.
+//           Both ASCII (P3) and binary (P6) images are accepted, going
+//           by the magic number in the header. The rest of the stream
+//           is read in one go and parsed with the in-memory reader below.
 void Image_init(Image* img, std::istream& is);
 
+// REQUIRES: img points to an Image
+//           data points to size bytes holding an image in PPM format
+//           without comments (any kind of whitespace is ok)
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image by parsing the PPM text in memory,
+//           the same way Image_init(img, is) parses a stream.
+// NOTE:     The pixels of large P3 images are parsed on all cores, as
+//           set by Image_set_text_parallelism.
+void Image_init(Image* img, const char* data, std::size_t size);
+
+// How ASCII (P3) text is split between threads when it is parsed or
+// printed. Settings only change how fast images are read and written,
+// never what is read or written.
+struct TextParallelism {
+  unsigned threads;             // most threads to use, 0 for one per core
+  std::size_t parse_min_bytes;  // smallest P3 body split into chunks
+  std::size_t parse_min_chunk;  // smallest chunk given to a thread
+  std::size_t print_block;      // bytes of text formatted at a time
+};
+
+// EFFECTS:  Returns the current settings for splitting P3 text between
+//           threads.
+TextParallelism Image_text_parallelism();
+
+// MODIFIES: the settings for splitting P3 text between threads
+// EFFECTS:  Replaces the settings with the given ones, which apply to
+//           every image read afterwards.
+// NOTE:     Not safe to call while another thread reads an image.
+void Image_set_text_parallelism(const TextParallelism &settings);
+
+// REQUIRES: img points to an Image
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image from the PPM file with the given name,
+//           which is memory-mapped and parsed in place. Returns whether
+//           the file could be opened.
+bool Image_read(Image* img, const std::string& filename);
+
 // REQUIRES: img points to a valid Image
 // MODIFIES: os
 // EFFECTS:  Writes the image to the given output stream in PPM format.
@@ -62,6 +105,15 @@ void Image_init(Image* img, std::istream& is);
 //           for an example.
 void Image_print(const Image* img, std::ostream& os);
 
+// REQUIRES: img points to a valid Image
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in binary PPM
+//           format: the header as Image_print writes it but with magic
+//           P6, followed by three bytes per pixel (red, green, blue) in
+//           row-major order with no separators.
+// NOTE:     Open file streams in binary mode for this format.
+void Image_print_binary(const Image* img, std::ostream& os);
+
 // REQUIRES: img points to a valid Image
 // EFFECTS:  Returns the width of the Image.
 int Image_width(const Image* img);
@@ -89,4 +141,179 @@ void Image_set_pixel(Image* img, int row, int column, Pixel color);
 // EFFECTS:  Sets each pixel in the image to the given color.
 void Image_fill(Image* img, Pixel color);
 
+// The same row of the three channels of an Image. T is uint8_t, or
+// const uint8_t for a read-only row.
+template <typename T>
+struct ImageRow {
+  RowSpan<T> red;
+  RowSpan<T> green;
+  RowSpan<T> blue;
+};
+
+// REQUIRES: img points to a valid Image
+//           0 <= row && row < Image_height(img)
+// MODIFIES: (The returned spans may be used to modify the row.)
+// EFFECTS:  Returns the given row of each channel of the Image.
+// NOTE:     Inlined like Matrix_row, for loops over whole rows.
+inline ImageRow<uint8_t> Image_row(Image* img, int row) {
+  return { Matrix_row(&img->red_channel, row),
+           Matrix_row(&img->green_channel, row),
+           Matrix_row(&img->blue_channel, row) };
+}
+
+// REQUIRES: img points to a valid Image
+//           0 <= row && row < Image_height(img)
+// EFFECTS:  Returns the given row of each channel of the Image,
+//           read-only.
+inline ImageRow<const uint8_t> Image_row(const Image* img, int row) {
+  return { Matrix_row(&img->red_channel, row),
+           Matrix_row(&img->green_channel, row),
+           Matrix_row(&img->blue_channel, row) };
+}
+
+// Representation of 2D RGB image with interleaved channels.
+// Each pixel is stored as three consecutive bytes (red, green, blue)
+// and rows are contiguous, so a pixel lives on a single cache line.
+// The Image_* functions below are overloaded for PackedImage, so code
+// written against them (e.g. the processing module) can use either
+// representation. PackedImage objects may be copied.
+struct PackedImage {
+  int width;
+  int height;
+  std::vector<uint8_t> data;
+};
+
+// REQUIRES: img points to a PackedImage
+//           0 < width && 0 < height
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage with the given width and height,
+//           with all pixels initialized to RGB values of 0.
+void Image_init(PackedImage* img, int width, int height);
+
+// REQUIRES: img points to a PackedImage
+//           is contains an image in PPM format without comments
+//           (any kind of whitespace is ok)
+// MODIFIES: *img, is (which is read to its end, past the image)
+// EFFECTS:  Initializes the PackedImage by reading in an image in PPM
+//           format from the given input stream.
+void Image_init(PackedImage* img, std::istream& is);
+
+// REQUIRES: img points to a PackedImage
+//           data points to size bytes holding an image in PPM format
+//           without comments (any kind of whitespace is ok)
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage by parsing the PPM text in
+//           memory, the same way Image_init(img, is) parses a stream.
+void Image_init(PackedImage* img, const char* data, std::size_t size);
+
+// REQUIRES: img points to a PackedImage
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage from the PPM file with the given
+//           name, which is memory-mapped and parsed in place. Returns
+//           whether the file could be opened.
+bool Image_read(PackedImage* img, const std::string& filename);
+
+// REQUIRES: img points to a PackedImage
+//           src points to a valid Image
+// MODIFIES: *img
+// EFFECTS:  Initializes the PackedImage as a copy of the given Image.
+void Image_init(PackedImage* img, const Image* src);
+
+// REQUIRES: img points to an Image
+//           src points to a valid PackedImage
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image as a copy of the given PackedImage.
+void Image_init(Image* img, const PackedImage* src);
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in PPM format,
+//           exactly as Image_print does for an Image.
+void Image_print(const PackedImage* img, std::ostream& os);
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: os
+// EFFECTS:  Writes the image to the given output stream in binary PPM
+//           format, exactly as Image_print_binary does for an Image.
+void Image_print_binary(const PackedImage* img, std::ostream& os);
+
+// REQUIRES: img points to a valid PackedImage
+// EFFECTS:  Returns the width of the PackedImage.
+int Image_width(const PackedImage* img);
+
+// REQUIRES: img points to a valid PackedImage
+// EFFECTS:  Returns the height of the PackedImage.
+int Image_height(const PackedImage* img);
+
+// REQUIRES: img points to a valid PackedImage
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// EFFECTS:  Returns the pixel in the PackedImage at the given row and
+//           column.
+Pixel Image_get_pixel(const PackedImage* img, int row, int column);
+
+// REQUIRES: img points to a valid PackedImage
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// MODIFIES: *img
+// EFFECTS:  Sets the pixel in the PackedImage at the given row and column
+//           to the given color.
+void Image_set_pixel(PackedImage* img, int row, int column, Pixel color);
+
+// REQUIRES: img points to a valid PackedImage
+// MODIFIES: *img
+// EFFECTS:  Sets each pixel in the image to the given color.
+void Image_fill(PackedImage* img, Pixel color);
+
+// A non-owning view of an RGB image held elsewhere, e.g. a frame decoded
+// by another library, with the pixels of each row interleaved as in a
+// PackedImage. Rows are stride bytes apart, so the view can cover a
+// sub-rectangle of a larger buffer. The Image_* functions below are
+// overloaded for ImageView, and the processing functions instantiated
+// for it work on the viewed pixels in place. ImageView objects may be
+// copied; copies view the same pixels.
+struct ImageView {
+  int width;
+  int height;
+  std::ptrdiff_t stride;
+  uint8_t* data;
+};
+
+// REQUIRES: view points to an ImageView
+//           0 < shape.width && 0 < shape.height
+//           data points to shape.height rows of 3 * shape.width bytes,
+//           each starting shape.stride bytes after the one before
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over the given pixels.
+void ImageView_init(ImageView* view, uint8_t* data, const ViewShape &shape);
+
+// REQUIRES: view points to an ImageView
+//           img points to a valid PackedImage
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over all pixels of the PackedImage.
+void ImageView_init(ImageView* view, PackedImage* img);
+
+// REQUIRES: img points to a valid ImageView
+// EFFECTS:  Returns the width of the viewed image.
+int Image_width(const ImageView* img);
+
+// REQUIRES: img points to a valid ImageView
+// EFFECTS:  Returns the height of the viewed image.
+int Image_height(const ImageView* img);
+
+// REQUIRES: img points to a valid ImageView
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// EFFECTS:  Returns the viewed pixel at the given row and column.
+Pixel Image_get_pixel(const ImageView* img, int row, int column);
+
+// REQUIRES: img points to a valid ImageView
+//           0 <= row && row < Image_height(img)
+//           0 <= column && column < Image_width(img)
+// MODIFIES: the viewed pixels
+// EFFECTS:  Sets the viewed pixel at the given row and column to the
+//           given color.
+void Image_set_pixel(ImageView* img, int row, int column,
+                     Pixel color);
+
 #endif // IMAGE_HPP
@@ -1,5 +1,9 @@
 #include "Matrix.hpp"
 #include "Image_test_helpers.hpp"
+#include "jpeg.hpp"
+#include "qoi.hpp"
+#include "snapshot.hpp"
+#include <cstdio>
 #include "unit_test_framework.hpp"
 #include <iostream>
 #include <string>
@@ -218,6 +222,381 @@ TEST(test_image_fill_basic)
     }
   }
 }
+
+// Tests that PackedImage behaves like Image and converts losslessly
+TEST(test_packed_image)
+{
+  Image img;
+  Image_init(&img, 3, 2);
+  Pixel purple = {128, 0, 128};
+  Pixel white = {255, 255, 255};
+  Image_fill(&img, purple);
+  Image_set_pixel(&img, 1, 2, white);
+
+  PackedImage packed;
+  Image_init(&packed, &img);
+  ASSERT_EQUAL(Image_width(&packed), 3);
+  ASSERT_EQUAL(Image_height(&packed), 2);
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&packed, 0, 0), purple));
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&packed, 1, 2), white));
+
+  std::ostringstream expected;
+  Image_print(&img, expected);
+  std::ostringstream actual;
+  Image_print(&packed, actual);
+  ASSERT_EQUAL(actual.str(), expected.str());
+
+  Image_set_pixel(&packed, 0, 1, white);
+  Image back;
+  Image_init(&back, &packed);
+  Image_set_pixel(&img, 0, 1, white);
+  ASSERT_TRUE(Image_equal(&back, &img));
+
+  std::istringstream ss_input(expected.str());
+  PackedImage parsed;
+  Image_init(&parsed, ss_input);
+  std::ostringstream reprinted;
+  Image_print(&parsed, reprinted);
+  ASSERT_EQUAL(reprinted.str(), expected.str());
+}
+
+// Tests that the in-memory PPM reader accepts any kind of whitespace,
+// including none at the end, and fills every channel
+TEST(test_image_init_PPM_buffer)
+{
+  string text = "P3\t2\r\n1 \v255\n\n12\t34  56\f7 8\r\n9";
+
+  Image img;
+  Image_init(&img, text.data(), text.size());
+  ASSERT_EQUAL(Image_width(&img), 2);
+  ASSERT_EQUAL(Image_height(&img), 1);
+  Pixel first = {12, 34, 56};
+  Pixel second = {7, 8, 9};
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&img, 0, 0), first));
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&img, 0, 1), second));
+
+  PackedImage packed;
+  Image_init(&packed, text.data(), text.size());
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&packed, 0, 0), first));
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&packed, 0, 1), second));
+
+  istringstream input(text);
+  Image streamed;
+  Image_init(&streamed, input);
+  ASSERT_TRUE(Image_equal(&streamed, &img));
+}
+
+// Tests that binary PPM output reads back as the same image, including
+// pixel bytes that are whitespace or digits in ASCII
+TEST(test_image_binary_PPM)
+{
+  Image img;
+  Image_init(&img, 3, 2);
+  Pixel tricky = {'\n', ' ', '7'};
+  Pixel other = {0, 255, '\t'};
+  Image_fill(&img, other);
+  Image_set_pixel(&img, 0, 0, tricky);
+  Image_set_pixel(&img, 1, 2, tricky);
+
+  ostringstream output;
+  Image_print_binary(&img, output);
+  ASSERT_EQUAL(output.str().substr(0, 11), string("P6\n3 2\n255\n"));
+  ASSERT_EQUAL(output.str().size(), 11u + 3 * 3 * 2);
+
+  istringstream input(output.str());
+  Image parsed;
+  Image_init(&parsed, input);
+  ASSERT_TRUE(Image_equal(&parsed, &img));
+
+  PackedImage packed;
+  string text = output.str();
+  Image_init(&packed, text.data(), text.size());
+  ostringstream packed_output;
+  Image_print_binary(&packed, packed_output);
+  ASSERT_EQUAL(packed_output.str(), output.str());
+}
+
+// Tests that QOI output matches the format for a known case and reads
+// back as the same image when every kind of chunk is used
+TEST(test_image_qoi)
+{
+  Image black;
+  Image_init(&black, 1, 1);
+  vector<unsigned char> encoded;
+  qoi_encode(&black, &encoded);
+  const unsigned char expected[] = {
+    'q', 'o', 'i', 'f', 0, 0, 0, 1, 0, 0, 0, 1, 3, 0,
+    0xc0,                                  // run of one pixel
+    0, 0, 0, 0, 0, 0, 0, 1 };
+  ASSERT_EQUAL(encoded.size(), sizeof expected);
+  ASSERT_TRUE(equal(encoded.begin(), encoded.end(), expected));
+
+  // Runs longer than a chunk holds, small and large steps that wrap
+  // around, and colors seen before
+  Image img;
+  Image_init(&img, 70, 3);
+  for (int column = 0; column < 70; ++column) {
+    Pixel step = {column % 5, 255 - column, (column * 40) % 256};
+    Pixel far = {(column * 97) % 256, (column * 31) % 256, column % 7};
+    Image_set_pixel(&img, 1, column, step);
+    Image_set_pixel(&img, 2, column, column % 3 ? far : step);
+  }
+  qoi_encode(&img, &encoded);
+  Image decoded;
+  ASSERT_TRUE(qoi_decode(&decoded, encoded.data(), encoded.size()));
+  ASSERT_TRUE(Image_equal(&decoded, &img));
+
+  encoded.resize(encoded.size() / 2);
+  ASSERT_FALSE(qoi_decode(&decoded, encoded.data(), encoded.size()));
+  encoded[0] = 'p';
+  ASSERT_FALSE(qoi_decode(&decoded, encoded.data(), encoded.size()));
+
+  ASSERT_TRUE(has_qoi_extension("out.qoi"));
+  ASSERT_TRUE(has_qoi_extension("dir.d/OUT.QOI"));
+  ASSERT_FALSE(has_qoi_extension("qoi"));
+  ASSERT_FALSE(has_qoi_extension("out.ppm"));
+}
+
+// Tests that JPEG inputs are decoded at the smallest scale that still
+// covers the minimum size, rounding scaled sizes up as libjpeg does, and
+// at full size when every reduced scale falls below it
+TEST(test_jpeg_scale_denom)
+{
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 0, 0), 1u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 100, 75), 8u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 50, 0), 8u);
+  ASSERT_EQUAL(jpeg_scale_denom(801, 601, 101, 76), 8u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 101, 75), 4u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 100, 76), 4u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 0, 300), 2u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 400, 301), 1u);
+  ASSERT_EQUAL(jpeg_scale_denom(800, 600, 800, 600), 1u);
+  ASSERT_EQUAL(jpeg_scale_denom(3, 2, 1, 1), 8u);
+  ASSERT_EQUAL(jpeg_scale_denom(3, 2, 2, 1), 2u);
+}
+
+// Tests that Matrix and Image snapshots read back in place through views
+// with padded rows, and that views of the wrong type are refused
+TEST(test_snapshot)
+{
+  Matrix16 mat;
+  Matrix_init(&mat, 3, 2);
+  for (int i = 0; i < 6; ++i) {
+    mat.data[i] = 1000 * i + 7;
+  }
+  ASSERT_TRUE(Matrix_write_snapshot(&mat, "snapshot_test.out.snap"));
+
+  Snapshot snap;
+  ASSERT_TRUE(Snapshot_open(&snap, "snapshot_test.out.snap"));
+  ASSERT_EQUAL(snap.planes, 1);
+  MatrixView<const int> wrong;
+  ASSERT_FALSE(Snapshot_view(&snap, 0, &wrong));
+  MatrixView<const uint16_t> view;
+  ASSERT_TRUE(Snapshot_view(&snap, 0, &view));
+  ASSERT_EQUAL(Matrix_width(&view), 3);
+  ASSERT_EQUAL(Matrix_height(&view), 2);
+  ASSERT_EQUAL(view.stride * sizeof(uint16_t) % 64, 0u);
+  for (int row = 0; row < 2; ++row) {
+    for (int column = 0; column < 3; ++column) {
+      ASSERT_EQUAL(*Matrix_at(&view, row, column),
+                   *Matrix_at(&mat, row, column));
+    }
+  }
+  Snapshot_close(&snap);
+
+  Image img;
+  Image_init(&img, 70, 2);
+  Pixel purple = {128, 0, 128};
+  Image_fill(&img, purple);
+  Pixel white = {255, 255, 255};
+  Image_set_pixel(&img, 1, 69, white);
+  ASSERT_TRUE(Image_write_snapshot(&img, "snapshot_test.out.snap"));
+  ASSERT_TRUE(Snapshot_open(&snap, "snapshot_test.out.snap"));
+  ASSERT_EQUAL(snap.planes, 3);
+  const Matrix8* channels[3] = { &img.red_channel, &img.green_channel,
+                                 &img.blue_channel };
+  for (int plane = 0; plane < 3; ++plane) {
+    MatrixView<const uint8_t> channel;
+    ASSERT_TRUE(Snapshot_view(&snap, plane, &channel));
+    for (int row = 0; row < 2; ++row) {
+      for (int column = 0; column < 70; ++column) {
+        ASSERT_EQUAL(*Matrix_at(&channel, row, column),
+                     *Matrix_at(channels[plane], row, column));
+      }
+    }
+  }
+  Snapshot_close(&snap);
+
+  remove("snapshot_test.out.snap");
+  ASSERT_FALSE(Snapshot_open(&snap, "snapshot_test.out.snap"));
+}
+
+// Tests that an ImageView over a sub-rectangle of a larger buffer reads
+// and writes only the pixels it covers
+TEST(test_image_view)
+{
+  PackedImage buffer;
+  Image_init(&buffer, 4, 3);
+  Pixel gray = {100, 100, 100};
+  Image_fill(&buffer, gray);
+  Pixel red = {255, 0, 0};
+  Image_set_pixel(&buffer, 1, 2, red);
+
+  ImageView view;
+  ImageView_init(&view, &buffer.data[3 * (1 * 4 + 1)], { 2, 2, 3 * 4 });
+  ASSERT_EQUAL(Image_width(&view), 2);
+  ASSERT_EQUAL(Image_height(&view), 2);
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&view, 0, 1), red));
+
+  Pixel blue = {0, 0, 255};
+  Image_set_pixel(&view, 1, 0, blue);
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&buffer, 2, 1), blue));
+  for (int row = 0; row < 3; ++row) {
+    for (int column = 0; column < 4; ++column) {
+      bool changed = (row == 1 && column == 2) || (row == 2 && column == 1);
+      if (!changed) {
+        ASSERT_TRUE(Pixel_equal(Image_get_pixel(&buffer, row, column), gray));
+      }
+    }
+  }
+
+  ImageView whole;
+  ImageView_init(&whole, &buffer);
+  ASSERT_EQUAL(Image_width(&whole), 4);
+  ASSERT_TRUE(Pixel_equal(Image_get_pixel(&whole, 2, 1), blue));
+}
+
+// REQUIRES: img points to a valid Image
+// EFFECTS:  Returns img in P3 format with every kind of whitespace, and
+//           runs of it, between the values, some of which have leading
+//           zeros.
+static string varied_ppm_text(const Image *img) {
+  const char *spaces[] = { " ", "\t", "\n", "\r\n", "\v", "\f", "   ",
+                           " \t\n " };
+  ostringstream text;
+  text << "P3 " << Image_width(img) << " " << Image_height(img) << " 255\n";
+  int next = 0;
+  for (int row = 0; row < Image_height(img); ++row) {
+    for (int column = 0; column < Image_width(img); ++column) {
+      Pixel p = Image_get_pixel(img, row, column);
+      for (int value : { p.r, p.g, p.b }) {
+        text << (next % 5 == 0 ? "00" : "") << value << spaces[next % 8];
+        ++next;
+      }
+    }
+  }
+  return text.str();
+}
+
+// REQUIRES: text holds an image in PPM format without comments
+// EFFECTS:  Checks that the text reads as the same Image and PackedImage
+//           when its body is split into chunks of a few bytes between
+//           2 to 8 threads as when it is parsed by one thread, and
+//           returns the Image read.
+static Image check_chunked_parse_matches_serial(const string &text) {
+  TextParallelism saved = Image_text_parallelism();
+  Image_set_text_parallelism({ 1, 0, 1, saved.print_block });
+  Image serial;
+  Image_init(&serial, text.data(), text.size());
+  for (unsigned threads = 2; threads <= 8; ++threads) {
+    Image_set_text_parallelism({ threads, 0, 1, saved.print_block });
+    Image chunked;
+    Image_init(&chunked, text.data(), text.size());
+    ASSERT_TRUE(Image_equal(&chunked, &serial));
+    PackedImage packed;
+    Image_init(&packed, text.data(), text.size());
+    Image unpacked;
+    Image_init(&unpacked, &packed);
+    ASSERT_TRUE(Image_equal(&unpacked, &serial));
+  }
+  Image_set_text_parallelism(saved);
+  return serial;
+}
+
+// Tests that P3 bodies split between threads at whitespace read the
+// same as when parsed serially, with chunk bounds inside words and
+// runs of whitespace, values past the last one the image holds, words
+// that are not numbers, and bodies that end early
+TEST(test_image_init_PPM_chunked)
+{
+  Image img;
+  Image_init(&img, 7, 5);
+  for (int row = 0; row < 5; ++row) {
+    for (int column = 0; column < 7; ++column) {
+      Pixel p = { (row * 53 + column * 31) % 256, (column * 97) % 256,
+                  row * 7 + column };
+      Image_set_pixel(&img, row, column, p);
+    }
+  }
+  string text = varied_ppm_text(&img);
+  Image parsed = check_chunked_parse_matches_serial(text);
+  ASSERT_TRUE(Image_equal(&parsed, &img));
+
+  string extra;
+  for (int i = 0; i < 500; ++i) {
+    extra += "1 22 333\n4\t5 6 ";
+  }
+  parsed = check_chunked_parse_matches_serial(text + extra);
+  ASSERT_TRUE(Image_equal(&parsed, &img));
+
+  string garbled = text;
+  garbled.replace(garbled.find("0035"), 4, "3x5");
+  parsed = check_chunked_parse_matches_serial(garbled);
+  ASSERT_EQUAL(Image_get_pixel(&parsed, 0, 3).g, 0);
+  ASSERT_EQUAL(Image_get_pixel(&parsed, 0, 3).b, 3);
+
+  check_chunked_parse_matches_serial(text.substr(0, text.size() - 40));
+}
+
+// REQUIRES: img points to a valid Image
+// EFFECTS:  Checks that img prints the same, as an Image and as a
+//           PackedImage, when it is formatted in blocks of the given
+//           size by 2 to 5 threads as when it is printed by one thread.
+static void check_blocked_print_matches_serial(const Image *img,
+                                               size_t block) {
+  TextParallelism saved = Image_text_parallelism();
+  Image_set_text_parallelism({ 1, saved.parse_min_bytes,
+                               saved.parse_min_chunk, saved.print_block });
+  ostringstream serial;
+  Image_print(img, serial);
+  PackedImage packed;
+  Image_init(&packed, img);
+  for (unsigned threads = 2; threads <= 5; ++threads) {
+    Image_set_text_parallelism({ threads, saved.parse_min_bytes,
+                                 saved.parse_min_chunk, block });
+    ostringstream blocked;
+    Image_print(img, blocked);
+    ASSERT_EQUAL(blocked.str(), serial.str());
+    ostringstream packed_blocked;
+    Image_print(&packed, packed_blocked);
+    ASSERT_EQUAL(packed_blocked.str(), serial.str());
+  }
+  Image_set_text_parallelism(saved);
+}
+
+// Tests that images printed in many blocks of rows by several threads
+// come out byte for byte as when printed serially, with blocks of one
+// row, of a few rows, and with fewer blocks than threads
+TEST(test_image_print_blocked)
+{
+  Image img;
+  Image_init(&img, 5, 11);
+  for (int row = 0; row < 11; ++row) {
+    for (int column = 0; column < 5; ++column) {
+      Pixel p = { row * 23 % 256, column * 60, (row + column) % 2 * 255 };
+      Image_set_pixel(&img, row, column, p);
+    }
+  }
+  check_blocked_print_matches_serial(&img, 1);
+  check_blocked_print_matches_serial(&img, 3 * (12 * 5 + 1));
+  check_blocked_print_matches_serial(&img, 4 * (12 * 5 + 1) + 7);
+
+  Image small;
+  Image_init(&small, 2, 2);
+  Image_fill(&small, { 9, 99, 199 });
+  check_blocked_print_matches_serial(&small, 1);
+}
+
 // IMPLEMENT YOUR TEST FUNCTIONS HERE
 // You are encouraged to use any functions from Image_test_helpers.hpp as needed.
 
@@ -1,5 +1,7 @@
 #include <cassert>
 #include "Matrix.hpp"
+#include "simd.hpp"
+#include "text_writer.hpp"
 
 using namespace std;
 
@@ -8,7 +10,8 @@ using namespace std;
 // MODIFIES: *mat
 // EFFECTS:  Initializes *mat as a Matrix with the given width and height,
 //           with all elements initialized to 0.
-void Matrix_init(Matrix* mat, int width, int height) {
+template <typename T>
+void Matrix_init(BasicMatrix<T>* mat, int width, int height) {
   mat->width = width;
   mat->height = height;
   long long count = (long long)width * (long long)height;
@@ -23,27 +26,35 @@ void Matrix_init(Matrix* mat, int width, int height) {
 //           Each element is followed by a space and each row is followed
 //           by a newline. This means there will be an "extra" space at
 //           the end of each line.
-void Matrix_print(const Matrix* mat, std::ostream& os) {
-  os << mat->width << " " << mat->height << endl;
-  
+template <typename T>
+void Matrix_print(const BasicMatrix<T>* mat, std::ostream& os) {
+  TextWriter writer;
+  TextWriter_init(&writer, &os);
+  TextWriter_put(&writer, mat->width, ' ');
+  TextWriter_put(&writer, mat->height, '\n');
+
   for (int i = 0; i < mat->height; ++i) {
+    const T *row = mat->data.data() + (long long)i * mat->width;
     for (int j = 0; j < mat->width; ++j) {
-      int index = i * mat->width + j;
-      os << mat->data[index] << " ";
+      // unary + formats 8-bit elements like the other integer types
+      TextWriter_put(&writer, +row[j], ' ');
     }
-    os << endl;
+    TextWriter_put_char(&writer, '\n');
   }
+  TextWriter_finish(&writer);
 }
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the width of the Matrix.
-int Matrix_width(const Matrix* mat) {
+template <typename T>
+int Matrix_width(const BasicMatrix<T>* mat) {
   return mat->width;
 }
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the height of the Matrix.
-int Matrix_height(const Matrix* mat) {
+template <typename T>
+int Matrix_height(const BasicMatrix<T>* mat) {
   return mat->height;
 }
 
@@ -55,7 +66,8 @@ int Matrix_height(const Matrix* mat) {
 //            element in the Matrix.)
 // EFFECTS:  Returns a pointer to the element in the Matrix
 //           at the given row and column.
-int* Matrix_at(Matrix* mat, int row, int column) {
+template <typename T>
+T* Matrix_at(BasicMatrix<T>* mat, int row, int column) {
   int w = mat->width;
   long long index = (long long)row * (long long)w + (long long)column;
   return &mat -> data[index];
@@ -67,7 +79,8 @@ int* Matrix_at(Matrix* mat, int row, int column) {
 //
 // EFFECTS:  Returns a pointer-to-const to the element in
 //           the Matrix at the given row and column.
-const int* Matrix_at(const Matrix* mat, int row, int column) {
+template <typename T>
+const T* Matrix_at(const BasicMatrix<T>* mat, int row, int column) {
   int w = mat->width;
   long long index = (long long)row * (long long)w + (long long)column;
   return &mat -> data[index];
@@ -76,8 +89,10 @@ const int* Matrix_at(const Matrix* mat, int row, int column) {
 // REQUIRES: mat points to a valid Matrix
 // MODIFIES: *mat
 // EFFECTS:  Sets each element of the Matrix to the given value.
-void Matrix_fill(Matrix* mat, int value) {
-  for (int &x : mat->data) {
+template <typename T>
+void Matrix_fill(BasicMatrix<T>* mat,
+                 typename BasicMatrix<T>::value_type value) {
+  for (T &x : mat->data) {
     x = value;
   }
 }
@@ -87,37 +102,213 @@ void Matrix_fill(Matrix* mat, int value) {
 // EFFECTS:  Sets each element on the border of the Matrix to
 //           the given value. These are all elements in the first/last
 //           row or the first/last column.
-void Matrix_fill_border(Matrix* mat, int value) {
+template <typename T>
+void Matrix_fill_border(BasicMatrix<T>* mat,
+                        typename BasicMatrix<T>::value_type value) {
   int h = mat->height;
   int w = mat->width;
 
-  for (int r = 0; r < h; ++r) {
-    for (int c = 0; c < w; ++c) {
-      if (r == 0 || r == h - 1 || c == 0 || c == w - 1) {
-        *Matrix_at(mat, r, c) = value;
-      }
-    }
+  for (T &x : Matrix_row(mat, 0)) {
+    x = value;
+  }
+  for (T &x : Matrix_row(mat, h - 1)) {
+    x = value;
+  }
+  for (int r = 1; r < h - 1; ++r) {
+    RowSpan<T> row = Matrix_row(mat, r);
+    row[0] = value;
+    row[w - 1] = value;
   }
 }
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the value of the maximum element in the Matrix
-int Matrix_max(const Matrix* mat) {
-  int max =  *Matrix_at(mat, 0, 0);
+template <typename T>
+T Matrix_max(const BasicMatrix<T>* mat) {
+  T max = Matrix_row(mat, 0)[0];
   int h = mat->height;
-  int w = mat->width;
 
   for (int r = 0; r < h; ++r) {
-    for (int c = 0; c < w; ++c) {
-      int val = *Matrix_at(mat, r, c);
-      if (val > max) {
-        max = val;
-      }
+    for (T val : Matrix_row(mat, r)) {
+      max = val > max ? val : max;
     }
   }
   return max;
 }
 
+// Row minimum kernels
+// ------------------------------------------------------------------
+// The row-min functions below scan a contiguous run of elements. For
+// 32-bit element types (int and uint32_t, used by cost matrices) long
+// runs are scanned with AVX2 or SSE4.1 when the CPU supports it,
+// selected at runtime (see simd.hpp). The argmin is computed as the
+// minimum followed by a search for its first occurrence, which keeps
+// the "leftmost on ties" contract of the scalar loop exactly.
+
+// Runs shorter than this are always scanned by the scalar loops.
+static const int SIMD_MIN_LENGTH = 16;
+
+// REQUIRES: n > 0
+// EFFECTS:  Returns the minimum of row[0], ..., row[n - 1].
+template <typename T>
+static T row_min_scalar(const T* row, int n) {
+  T min_val = row[0];
+  for (int i = 1; i < n; ++i) {
+    if (row[i] < min_val) {
+      min_val = row[i];
+    }
+  }
+  return min_val;
+}
+
+// REQUIRES: n > 0
+// EFFECTS:  Returns the index of the leftmost minimum of
+//           row[0], ..., row[n - 1].
+template <typename T>
+static int row_argmin_scalar(const T* row, int n) {
+  int min_col = 0;
+  for (int i = 1; i < n; ++i) {
+    if (row[i] < row[min_col]) {
+      min_col = i;
+    }
+  }
+  return min_col;
+}
+
+#if SIMD_X86
+
+// REQUIRES: n >= 8, T is a 32-bit type
+// EFFECTS:  Returns the minimum of row[0], ..., row[n - 1].
+template <typename T>
+__attribute__((target("avx2")))
+static T row_min_avx2(const T* row, int n) {
+  __m256i best = _mm256_loadu_si256((const __m256i*)row);
+  int i = 8;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(row + i));
+    best = min_lanes(best, v, row);
+  }
+  T lanes[8];
+  _mm256_storeu_si256((__m256i*)lanes, best);
+  T min_val = row_min_scalar(lanes, 8);
+  for (; i < n; ++i) {
+    if (row[i] < min_val) {
+      min_val = row[i];
+    }
+  }
+  return min_val;
+}
+
+// REQUIRES: value occurs in row[0], ..., row[n - 1], T is a 32-bit type
+// EFFECTS:  Returns the index of the first occurrence of value.
+template <typename T>
+__attribute__((target("avx2")))
+static int row_find_avx2(const T* row, int n, T value) {
+  __m256i target = _mm256_set1_epi32((int)value);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(row + i));
+    __m256i eq = _mm256_cmpeq_epi32(v, target);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  while (row[i] != value) {
+    ++i;
+  }
+  return i;
+}
+
+// REQUIRES: n >= 4, T is a 32-bit type
+// EFFECTS:  Returns the minimum of row[0], ..., row[n - 1].
+template <typename T>
+__attribute__((target("sse4.1")))
+static T row_min_sse41(const T* row, int n) {
+  __m128i best = _mm_loadu_si128((const __m128i*)row);
+  int i = 4;
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(row + i));
+    best = min_lanes(best, v, row);
+  }
+  T lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, best);
+  T min_val = row_min_scalar(lanes, 4);
+  for (; i < n; ++i) {
+    if (row[i] < min_val) {
+      min_val = row[i];
+    }
+  }
+  return min_val;
+}
+
+// REQUIRES: value occurs in row[0], ..., row[n - 1], T is a 32-bit type
+// EFFECTS:  Returns the index of the first occurrence of value.
+template <typename T>
+__attribute__((target("sse4.1")))
+static int row_find_sse41(const T* row, int n, T value) {
+  __m128i target = _mm_set1_epi32((int)value);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(row + i));
+    __m128i eq = _mm_cmpeq_epi32(v, target);
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  while (row[i] != value) {
+    ++i;
+  }
+  return i;
+}
+
+#endif // SIMD_X86
+
+// REQUIRES: n > 0
+// EFFECTS:  Returns the minimum of row[0], ..., row[n - 1].
+template <typename T>
+static T row_min(const T* row, int n) {
+#if SIMD_X86
+  if constexpr (sizeof(T) == 4) {
+    if (n >= SIMD_MIN_LENGTH) {
+      switch (simd_level()) {
+      case SIMD_AVX2:
+        return row_min_avx2(row, n);
+      case SIMD_SSE41:
+        return row_min_sse41(row, n);
+      case SIMD_NONE:
+        break;
+      }
+    }
+  }
+#endif
+  return row_min_scalar(row, n);
+}
+
+// REQUIRES: n > 0
+// EFFECTS:  Returns the index of the leftmost minimum of
+//           row[0], ..., row[n - 1].
+template <typename T>
+static int row_argmin(const T* row, int n) {
+#if SIMD_X86
+  if constexpr (sizeof(T) == 4) {
+    if (n >= SIMD_MIN_LENGTH) {
+      switch (simd_level()) {
+      case SIMD_AVX2:
+        return row_find_avx2(row, n, row_min_avx2(row, n));
+      case SIMD_SSE41:
+        return row_find_sse41(row, n, row_min_sse41(row, n));
+      case SIMD_NONE:
+        break;
+      }
+    }
+  }
+#endif
+  return row_argmin_scalar(row, n);
+}
+// ------------------------------------------------------------------
+
 // REQUIRES: mat points to a valid Matrix
 //           0 <= row && row < Matrix_height(mat)
 //           0 <= column_start && column_end <= Matrix_width(mat)
@@ -128,19 +319,11 @@ int Matrix_max(const Matrix* mat) {
 //           column_end (exclusive).
 //           If multiple elements are minimal, returns the column of
 //           the leftmost one.
-int Matrix_column_of_min_value_in_row(const Matrix* mat, int row,
+template <typename T>
+int Matrix_column_of_min_value_in_row(const BasicMatrix<T>* mat, int row,
                                       int column_start, int column_end) {
-  int min_col = column_start;
-  int min_val = *Matrix_at(mat, row, column_start);
-
-  for (int i = column_start + 1; i < column_end; ++i) {
-    int val = *Matrix_at(mat, row, i);
-    if (val < min_val) {
-      min_val = val;
-      min_col = i;
-    }
-  }
-  return min_col;
+  const T* first = Matrix_row(mat, row).data + column_start;
+  return column_start + row_argmin(first, column_end - column_start);
 }
 
 // REQUIRES: mat points to a valid Matrix
@@ -150,15 +333,81 @@ int Matrix_column_of_min_value_in_row(const Matrix* mat, int row,
 // EFFECTS:  Returns the minimal value in a particular region. The region
 //           is defined as elements in the given row and between
 //           column_start (inclusive) and column_end (exclusive).
-int Matrix_min_value_in_row(const Matrix* mat, int row,
-                            int column_start, int column_end) {
-  int min_val = *Matrix_at(mat, row, column_start);
-
-  for (int i = column_start + 1; i < column_end; ++i) {
-    int val = *Matrix_at(mat, row, i);
-    if (val < min_val) {
-      min_val = val;
-    }
-  }
-  return min_val;
+template <typename T>
+T Matrix_min_value_in_row(const BasicMatrix<T>* mat, int row,
+                          int column_start, int column_end) {
+  const T* first = Matrix_row(mat, row).data + column_start;
+  return row_min(first, column_end - column_start);
 }
+
+// REQUIRES: view points to a MatrixView
+//           0 < shape.width && 0 < shape.height
+//           shape.width <= shape.stride
+//           data points to shape.height rows of shape.width elements,
+//           each starting shape.stride elements after the one before
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over the given elements.
+template <typename T>
+void MatrixView_init(MatrixView<T>* view, T* data, const ViewShape &shape) {
+  assert(0 < shape.width && 0 < shape.height);
+  assert(shape.width <= shape.stride);
+  view->width = shape.width;
+  view->height = shape.height;
+  view->stride = shape.stride;
+  view->data = data;
+}
+
+// REQUIRES: view points to a valid MatrixView
+// EFFECTS:  Returns the width of the viewed matrix.
+template <typename T>
+int Matrix_width(const MatrixView<T>* view) {
+  return view->width;
+}
+
+// REQUIRES: view points to a valid MatrixView
+// EFFECTS:  Returns the height of the viewed matrix.
+template <typename T>
+int Matrix_height(const MatrixView<T>* view) {
+  return view->height;
+}
+
+// REQUIRES: view points to a valid MatrixView
+//           0 <= row && row < Matrix_height(view)
+//           0 <= column && column < Matrix_width(view)
+// EFFECTS:  Returns a pointer to the viewed element at the given row and
+//           column, which is const if T is.
+template <typename T>
+T* Matrix_at(const MatrixView<T>* view, int row, int column) {
+  return view->data + row * view->stride + column;
+}
+
+// Explicit instantiations for the element types used by the project.
+#define MATRIX_INSTANTIATE(T)                                              \
+  template void Matrix_init(BasicMatrix<T>*, int, int);                   \
+  template void Matrix_print(const BasicMatrix<T>*, std::ostream&);       \
+  template int Matrix_width(const BasicMatrix<T>*);                       \
+  template int Matrix_height(const BasicMatrix<T>*);                      \
+  template T* Matrix_at(BasicMatrix<T>*, int, int);                       \
+  template const T* Matrix_at(const BasicMatrix<T>*, int, int);           \
+  template void Matrix_fill(BasicMatrix<T>*, T);                          \
+  template void Matrix_fill_border(BasicMatrix<T>*, T);                   \
+  template T Matrix_max(const BasicMatrix<T>*);                           \
+  template int Matrix_column_of_min_value_in_row(const BasicMatrix<T>*,   \
+                                                 int, int, int);          \
+  template T Matrix_min_value_in_row(const BasicMatrix<T>*, int, int, int); \
+  MATRIX_VIEW_INSTANTIATE(T)                                              \
+  MATRIX_VIEW_INSTANTIATE(const T)
+
+#define MATRIX_VIEW_INSTANTIATE(T)                                         \
+  template void MatrixView_init(MatrixView<T>*, T*, const ViewShape &);   \
+  template int Matrix_width(const MatrixView<T>*);                        \
+  template int Matrix_height(const MatrixView<T>*);                       \
+  template T* Matrix_at(const MatrixView<T>*, int, int);
+
+MATRIX_INSTANTIATE(int)
+MATRIX_INSTANTIATE(uint8_t)
+MATRIX_INSTANTIATE(uint16_t)
+MATRIX_INSTANTIATE(uint32_t)
+
+#undef MATRIX_INSTANTIATE
+#undef MATRIX_VIEW_INSTANTIATE
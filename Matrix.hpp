@@ -9,15 +9,66 @@
  * Andrew DeOrio.
  */
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
+// Representation of a 2D matrix whose elements have type T.
+// BasicMatrix objects may be copied.
+// The Matrix_* functions below are instantiated in Matrix.cpp for
+// int, uint8_t, uint16_t and uint32_t elements.
+template <typename T>
+struct BasicMatrix {
+  using value_type = T;
+  int width;
+  int height;
+  std::vector<T> data;
+};
+
 // Representation of a 2D matrix of integers
 // Matrix objects may be copied.
-struct Matrix {
+using Matrix = BasicMatrix<int>;
+
+// Compact matrices for data with a known range, e.g. 8-bit color
+// channels, energies (at most 3900) and accumulated seam costs.
+using Matrix8 = BasicMatrix<uint8_t>;
+using Matrix16 = BasicMatrix<uint16_t>;
+using Matrix32 = BasicMatrix<uint32_t>;
+
+// The dimensions of a view, and the distance between the starts of its
+// rows: in elements for a MatrixView, in bytes for an ImageView.
+struct ViewShape {
   int width;
   int height;
-  std::vector<int> data;
+  std::ptrdiff_t stride;
+};
+
+// A non-owning view of a matrix whose elements are held elsewhere, e.g.
+// in a memory-mapped file. Rows are stride elements apart, so padded
+// rows can be viewed. T may be const-qualified for a read-only view.
+// MatrixView objects may be copied; copies view the same elements.
+template <typename T>
+struct MatrixView {
+  using value_type = T;
+  int width;
+  int height;
+  std::ptrdiff_t stride;
+  T* data;
+};
+
+// The elements of one row of a matrix, which are contiguous. It can be
+// indexed by column and used in a range-based for loop. T may be
+// const-qualified. RowSpan objects may be copied; copies refer to the
+// same elements.
+template <typename T>
+struct RowSpan {
+  T* data;
+  int size;
+
+  T& operator[](int column) const { return data[column]; }
+  T* begin() const { return data; }
+  T* end() const { return data + size; }
 };
 
 // REQUIRES: mat points to a Matrix
@@ -25,7 +76,8 @@ struct Matrix {
 // MODIFIES: *mat
 // EFFECTS:  Initializes *mat as a Matrix with the given width and height,
 //           with all elements initialized to 0.
-void Matrix_init(Matrix* mat, int width, int height);
+template <typename T>
+void Matrix_init(BasicMatrix<T>* mat, int width, int height);
 
 // REQUIRES: mat points to a valid Matrix
 // MODIFIES: os
@@ -35,15 +87,40 @@ void Matrix_init(Matrix* mat, int width, int height);
 //           Each element is followed by a space and each row is followed
 //           by a newline. This means there will be an "extra" space at
 //           the end of each line.
-void Matrix_print(const Matrix* mat, std::ostream& os);
+template <typename T>
+void Matrix_print(const BasicMatrix<T>* mat, std::ostream& os);
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the width of the Matrix.
-int Matrix_width(const Matrix* mat);
+template <typename T>
+int Matrix_width(const BasicMatrix<T>* mat);
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the height of the Matrix.
-int Matrix_height(const Matrix* mat);
+template <typename T>
+int Matrix_height(const BasicMatrix<T>* mat);
+
+// REQUIRES: mat points to a valid Matrix
+//           0 <= row && row < Matrix_height(mat)
+// MODIFIES: (The returned span may be used to modify the row.)
+// EFFECTS:  Returns the elements of the given row of the Matrix.
+// NOTE:     The row functions are defined here rather than in Matrix.cpp
+//           so that they are inlined. Loops that take a row once and
+//           index it by column leave the compiler a plain array to
+//           vectorize, where Matrix_at is a call per element.
+template <typename T>
+inline RowSpan<T> Matrix_row(BasicMatrix<T>* mat, int row) {
+  return { mat->data.data() + (std::ptrdiff_t)row * mat->width, mat->width };
+}
+
+// REQUIRES: mat points to a valid Matrix
+//           0 <= row && row < Matrix_height(mat)
+// EFFECTS:  Returns the elements of the given row of the Matrix,
+//           read-only.
+template <typename T>
+inline RowSpan<const T> Matrix_row(const BasicMatrix<T>* mat, int row) {
+  return { mat->data.data() + (std::ptrdiff_t)row * mat->width, mat->width };
+}
 
 // REQUIRES: mat points to a valid Matrix
 //           0 <= row && row < Matrix_height(mat)
@@ -53,7 +130,8 @@ int Matrix_height(const Matrix* mat);
 //            element in the Matrix.)
 // EFFECTS:  Returns a pointer to the element in the Matrix
 //           at the given row and column.
-int* Matrix_at(Matrix* mat, int row, int column);
+template <typename T>
+T* Matrix_at(BasicMatrix<T>* mat, int row, int column);
 
 // REQUIRES: mat points to a valid Matrix
 //           0 <= row && row < Matrix_height(mat)
@@ -61,23 +139,29 @@ int* Matrix_at(Matrix* mat, int row, int column);
 //
 // EFFECTS:  Returns a pointer-to-const to the element in
 //           the Matrix at the given row and column.
-const int* Matrix_at(const Matrix* mat, int row, int column);
+template <typename T>
+const T* Matrix_at(const BasicMatrix<T>* mat, int row, int column);
 
 // REQUIRES: mat points to a valid Matrix
 // MODIFIES: *mat
 // EFFECTS:  Sets each element of the Matrix to the given value.
-void Matrix_fill(Matrix* mat, int value);
+template <typename T>
+void Matrix_fill(BasicMatrix<T>* mat,
+                 typename BasicMatrix<T>::value_type value);
 
 // REQUIRES: mat points to a valid Matrix
 // MODIFIES: *mat
 // EFFECTS:  Sets each element on the border of the Matrix to
 //           the given value. These are all elements in the first/last
 //           row or the first/last column.
-void Matrix_fill_border(Matrix* mat, int value);
+template <typename T>
+void Matrix_fill_border(BasicMatrix<T>* mat,
+                        typename BasicMatrix<T>::value_type value);
 
 // REQUIRES: mat points to a valid Matrix
 // EFFECTS:  Returns the value of the maximum element in the Matrix
-int Matrix_max(const Matrix* mat);
+template <typename T>
+T Matrix_max(const BasicMatrix<T>* mat);
 
 // REQUIRES: mat points to a valid Matrix
 //           0 <= row && row < Matrix_height(mat)
@@ -89,7 +173,8 @@ int Matrix_max(const Matrix* mat);
 //           column_end (exclusive).
 //           If multiple elements are minimal, returns the column of
 //           the leftmost one.
-int Matrix_column_of_min_value_in_row(const Matrix* mat, int row,
+template <typename T>
+int Matrix_column_of_min_value_in_row(const BasicMatrix<T>* mat, int row,
                                       int column_start, int column_end);
 
 // REQUIRES: mat points to a valid Matrix
@@ -99,7 +184,45 @@ int Matrix_column_of_min_value_in_row(const Matrix* mat, int row,
 // EFFECTS:  Returns the minimal value in a particular region. The region
 //           is defined as elements in the given row and between
 //           column_start (inclusive) and column_end (exclusive).
-int Matrix_min_value_in_row(const Matrix* mat, int row,
-                            int column_start, int column_end);
+template <typename T>
+T Matrix_min_value_in_row(const BasicMatrix<T>* mat, int row,
+                          int column_start, int column_end);
+
+// REQUIRES: view points to a MatrixView
+//           0 < shape.width && 0 < shape.height
+//           shape.width <= shape.stride
+//           data points to shape.height rows of shape.width elements,
+//           each starting shape.stride elements after the one before
+// MODIFIES: *view
+// EFFECTS:  Initializes the view over the given elements.
+template <typename T>
+void MatrixView_init(MatrixView<T>* view, T* data, const ViewShape &shape);
+
+// REQUIRES: view points to a valid MatrixView
+// EFFECTS:  Returns the width of the viewed matrix.
+template <typename T>
+int Matrix_width(const MatrixView<T>* view);
+
+// REQUIRES: view points to a valid MatrixView
+// EFFECTS:  Returns the height of the viewed matrix.
+template <typename T>
+int Matrix_height(const MatrixView<T>* view);
+
+// REQUIRES: view points to a valid MatrixView
+//           0 <= row && row < Matrix_height(view)
+// EFFECTS:  Returns the viewed elements of the given row, which are
+//           const if T is.
+template <typename T>
+inline RowSpan<T> Matrix_row(const MatrixView<T>* view, int row) {
+  return { view->data + row * view->stride, view->width };
+}
+
+// REQUIRES: view points to a valid MatrixView
+//           0 <= row && row < Matrix_height(view)
+//           0 <= column && column < Matrix_width(view)
+// EFFECTS:  Returns a pointer to the viewed element at the given row and
+//           column, which is const if T is.
+template <typename T>
+T* Matrix_at(const MatrixView<T>* view, int row, int column);
 
 #endif // MATRIX_HPP
@@ -1,4 +1,5 @@
 #include "Matrix.hpp"
+#include "Image.hpp"
 #include "Matrix_test_helpers.hpp"
 #include "unit_test_framework.hpp"
 
@@ -313,6 +314,189 @@ TEST(test_matrix_min_value_in_row)
   ASSERT_EQUAL(Matrix_min_value_in_row(&mat, 2, 0, 6), 3);
   ASSERT_EQUAL(Matrix_min_value_in_row(&mat, 2, 2, 5), 3);
 }
+
+// Tests that compact element types hold their full range and that
+// 8-bit elements are printed as numbers rather than characters
+TEST(test_matrix_compact_types)
+{
+  Matrix8 mat8;
+  Matrix_init(&mat8, 3, 1);
+  *Matrix_at(&mat8, 0, 0) = 255;
+  *Matrix_at(&mat8, 0, 1) = 65;
+  *Matrix_at(&mat8, 0, 2) = 0;
+  ASSERT_EQUAL(Matrix_max(&mat8), 255);
+  ASSERT_EQUAL(Matrix_column_of_min_value_in_row(&mat8, 0, 0, 3), 2);
+
+  std::ostringstream out;
+  Matrix_print(&mat8, out);
+  ASSERT_EQUAL(out.str(), "3 1\n255 65 0 \n");
+
+  Matrix16 mat16;
+  Matrix_init(&mat16, 2, 2);
+  Matrix_fill(&mat16, 3900);
+  Matrix_fill_border(&mat16, 1);
+  ASSERT_EQUAL(Matrix_min_value_in_row(&mat16, 1, 0, 2), 1);
+
+  Matrix32 mat32;
+  Matrix_init(&mat32, 2, 1);
+  *Matrix_at(&mat32, 0, 1) = 4000000000u;
+  ASSERT_EQUAL(Matrix_max(&mat32), 4000000000u);
+}
+
+// Compares the row-min functions against a naive scan on long rows,
+// so that the vectorized kernels are exercised for every alignment
+// and tail length. Small value ranges produce many ties.
+template <typename T>
+static int naive_column_of_min(const BasicMatrix<T> *mat, int row,
+                               int start, int end) {
+  int min_col = start;
+  for (int c = start + 1; c < end; ++c) {
+    if (*Matrix_at(mat, row, c) < *Matrix_at(mat, row, min_col)) {
+      min_col = c;
+    }
+  }
+  return min_col;
+}
+
+template <typename T>
+static void check_row_min_matches_naive(unsigned value_range, T offset) {
+  const int width = 75;
+  BasicMatrix<T> mat;
+  Matrix_init(&mat, width, 2);
+  unsigned seed = 12345;
+  for (int c = 0; c < width; ++c) {
+    seed = seed * 1103515245 + 12345;
+    *Matrix_at(&mat, 0, c) = offset + T((seed >> 16) % value_range);
+    *Matrix_at(&mat, 1, c) = offset;
+  }
+
+  for (int row = 0; row < 2; ++row) {
+    for (int start = 0; start < width; ++start) {
+      for (int end = start + 1; end <= width; ++end) {
+        int naive_col = naive_column_of_min(&mat, row, start, end);
+        ASSERT_EQUAL(Matrix_column_of_min_value_in_row(&mat, row, start, end),
+                     naive_col);
+        ASSERT_EQUAL(Matrix_min_value_in_row(&mat, row, start, end),
+                     *Matrix_at(&mat, row, naive_col));
+      }
+    }
+  }
+}
+
+TEST(test_matrix_row_min_matches_naive)
+{
+  check_row_min_matches_naive<int>(5, -2);
+  check_row_min_matches_naive<int>(100000, -50000);
+  check_row_min_matches_naive<uint32_t>(7, 0);
+  check_row_min_matches_naive<uint32_t>(1000, 3000000000u);
+  check_row_min_matches_naive<uint16_t>(50, 0);
+  check_row_min_matches_naive<uint8_t>(3, 250);
+}
+
+// Prints a Matrix large enough to be written in several chunks and
+// checks the text against formatting every element with operator<<
+TEST(test_matrix_print_large)
+{
+  Matrix mat;
+  Matrix_init(&mat, 301, 257);
+  for (int i = 0; i < 257; ++i) {
+    for (int j = 0; j < 301; ++j) {
+      *Matrix_at(&mat, i, j) = (i * 7919 + j * 104729) % 2000003 - 1000000;
+    }
+  }
+
+  ostringstream expected;
+  expected << 301 << " " << 257 << "\n";
+  for (int i = 0; i < 257; ++i) {
+    for (int j = 0; j < 301; ++j) {
+      expected << *Matrix_at(&mat, i, j) << " ";
+    }
+    expected << "\n";
+  }
+
+  ostringstream actual;
+  Matrix_print(&mat, actual);
+  ASSERT_EQUAL(actual.str(), expected.str());
+}
+
+// Writes through the spans Matrix_row returns, by index and in a
+// range-based for loop, and checks that only that row of the Matrix
+// changes and that the const overload sees the same elements
+TEST(test_matrix_row)
+{
+  Matrix mat;
+  Matrix_init(&mat, 3, 2);
+  int value = 0;
+  for (int &element : Matrix_row(&mat, 1)) {
+    element = ++value;
+  }
+  Matrix_row(&mat, 0)[2] = 7;
+  for (int j = 0; j < 3; ++j) {
+    ASSERT_EQUAL(*Matrix_at(&mat, 0, j), j == 2 ? 7 : 0);
+    ASSERT_EQUAL(*Matrix_at(&mat, 1, j), j + 1);
+  }
+
+  const Matrix *const_mat = &mat;
+  RowSpan<const int> row = Matrix_row(const_mat, 1);
+  ASSERT_EQUAL(row.size, 3);
+  ASSERT_EQUAL(row.data, Matrix_at(const_mat, 1, 0));
+}
+
+// Checks that each row of a view over padded rows starts stride
+// elements after the one before, and that writing through a row in a
+// range-based for loop leaves the padding alone
+TEST(test_matrix_view_row)
+{
+  vector<int> buffer(5 * 3);
+  for (int i = 0; i < 15; ++i) {
+    buffer[i] = i;
+  }
+  MatrixView<int> view;
+  MatrixView_init(&view, &buffer[1], { 3, 3, 5 });
+  for (int row = 0; row < 3; ++row) {
+    RowSpan<int> span = Matrix_row(&view, row);
+    ASSERT_EQUAL(span.data, &buffer[1 + row * 5]);
+    ASSERT_EQUAL(span.size, 3);
+  }
+
+  for (int &element : Matrix_row(&view, 2)) {
+    element = -1;
+  }
+  for (int i = 0; i < 15; ++i) {
+    ASSERT_EQUAL(buffer[i], 11 <= i && i < 14 ? -1 : i);
+  }
+}
+
+// Writes through the channel spans Image_row returns and checks that
+// the pixels of that row, and only those, change
+TEST(test_image_row)
+{
+  Image img;
+  Image_init(&img, 2, 2);
+  ImageRow<uint8_t> pixels = Image_row(&img, 1);
+  for (uint8_t &red : pixels.red) {
+    red = 10;
+  }
+  pixels.green[0] = 20;
+  pixels.blue[1] = 30;
+
+  Pixel left = Image_get_pixel(&img, 1, 0);
+  Pixel right = Image_get_pixel(&img, 1, 1);
+  ASSERT_EQUAL(left.r, 10);
+  ASSERT_EQUAL(left.g, 20);
+  ASSERT_EQUAL(left.b, 0);
+  ASSERT_EQUAL(right.r, 10);
+  ASSERT_EQUAL(right.g, 0);
+  ASSERT_EQUAL(right.b, 30);
+  for (int j = 0; j < 2; ++j) {
+    Pixel above = Image_get_pixel(&img, 0, j);
+    ASSERT_EQUAL(above.r + above.g + above.b, 0);
+  }
+
+  const Image *const_img = &img;
+  ASSERT_EQUAL(Image_row(const_img, 1).blue[1], 30);
+}
+
 // ADD YOUR TESTS HERE
 // You are encouraged to use any functions from Matrix_test_helpers.hpp as needed.
 
@@ -13,6 +13,7 @@
 
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include "Image.hpp"
@@ -26,11 +27,30 @@
 bool has_jpeg_extension(const std::string &filename);
 
 // REQUIRES: image points to an Image object
+//           0 <= min_width && 0 <= min_height
 // MODIFIES: *image, cout
 // EFFECTS:  Reads a data from the JPEG file specified by the given
 //           filename into the given Image object.
+//           If min_width or min_height is positive, the image is
+//           decoded at the smallest of 1/8, 1/4 and 1/2 of its size
+//           that is still at least min_width wide and min_height
+//           tall, or at full size if none is.
 //           Returns whether or not the file was successfully read.
-bool read_jpeg(Image *image, const std::string &filename);
+// NOTE:     The scaling is done by libjpeg while decoding, in the DCT
+//           domain, so a smaller decode is also a faster one.
+bool read_jpeg(Image *image, const std::string &filename,
+               int min_width=0, int min_height=0);
+
+// REQUIRES: 0 < width && 0 < height
+//           0 <= min_width && 0 <= min_height
+// EFFECTS:  Returns the denominator d of the scale 1/d, one of 8, 4, 2
+//           and 1, at which read_jpeg decodes a width by height image
+//           for the given minimums: the largest d for which the decoded
+//           size, rounded up as libjpeg rounds it, is still at least
+//           min_width by min_height. Returns 1 if no d > 1 is, or if
+//           both minimums are 0.
+unsigned int jpeg_scale_denom(int width, int height, int min_width,
+                              int min_height);
 
 // REQUIRES: image points to a valid Image object
 // MODIFIES: the file corresponding to the given filename, cout
@@ -70,6 +90,31 @@ bool has_jpeg_extension(const std::string &filename) {
   return extension == "jpg" || extension == "jpeg";
 }
 
+// REQUIRES: 0 < width && 0 < height
+//           0 <= min_width && 0 <= min_height
+// EFFECTS:  Returns the denominator d of the scale 1/d, one of 8, 4, 2
+//           and 1, at which read_jpeg decodes a width by height image
+//           for the given minimums: the largest d for which the decoded
+//           size, rounded up as libjpeg rounds it, is still at least
+//           min_width by min_height. Returns 1 if no d > 1 is, or if
+//           both minimums are 0.
+unsigned int jpeg_scale_denom(int width, int height, int min_width,
+                              int min_height) {
+  static constexpr unsigned int MAX_SCALE_DENOM = 8;
+  if (min_width == 0 && min_height == 0) {
+    return 1;
+  }
+  for (unsigned int denom = MAX_SCALE_DENOM; denom > 1; denom /= 2) {
+    // libjpeg sizes a 1/denom decode as ceil(size / denom)
+    int scaled_width = (width + denom - 1) / denom;
+    int scaled_height = (height + denom - 1) / denom;
+    if (scaled_width >= min_width && scaled_height >= min_height) {
+      return denom;
+    }
+  }
+  return 1;
+}
+
 #if JPEG_HPP_USE_LIBJPEG
 
 // REQUIRES: buffer refers to an array that is at least as large as
@@ -83,18 +128,24 @@ bool has_jpeg_extension(const std::string &filename) {
 //           the value for all three colors of a pixel. Otherwise, the
 //           buffer is assumed to hold color values in RGB "striped"
 //           format (i.e. RGBRGB...).
+// NOTE:     Writes straight into the rows of the channel matrices
+//           rather than through Image_set_pixel.
 template<typename Buffer>
 static void copy_pixels(const Buffer &buffer, Image *image, int row,
                         bool grayscale) {
-  for (int column = 0; column < Image_width(image); ++column) {
-    Pixel pixel;
-    if (grayscale) {
-      pixel = {buffer[column], buffer[column], buffer[column]};
-    } else {
-      std::size_t base = 3 * column; // RGB format
-      pixel = {buffer[base], buffer[base + 1], buffer[base + 2]};
-    }
-    Image_set_pixel(image, row, column, pixel);
+  int width = Image_width(image);
+  ImageRow<uint8_t> pixels = Image_row(image, row);
+  if (grayscale) {
+    std::memcpy(pixels.red.data, &buffer[0], width);
+    std::memcpy(pixels.green.data, &buffer[0], width);
+    std::memcpy(pixels.blue.data, &buffer[0], width);
+    return;
+  }
+  for (int column = 0; column < width; ++column) {
+    std::size_t base = 3 * column; // RGB format
+    pixels.red[column] = buffer[base];
+    pixels.green[column] = buffer[base + 1];
+    pixels.blue[column] = buffer[base + 2];
   }
 }
 
@@ -124,13 +175,16 @@ static void read_jpeg8(j_decompress_ptr info_p, Image *image) {
 // MODIFIES: the contents of buffer
 // EFFECTS:  Reads a full row from image into buffer. Each color value
 //           is truncated by the value of Mask.
+// NOTE:     Reads straight from the rows of the channel matrices
+//           rather than through Image_get_pixel.
 template<int Mask, typename Buffer>
 static void get_row(const Image *image, Buffer &buffer, int row) {
-  for (int column = 0; column < Image_width(image); ++column) {
-    Pixel pixel = Image_get_pixel(image, row, column);
-    buffer[column * 3] = pixel.r & Mask;
-    buffer[column * 3 + 1] = pixel.g & Mask;
-    buffer[column * 3 + 2] = pixel.b & Mask;
+  int width = Image_width(image);
+  ImageRow<const uint8_t> pixels = Image_row(image, row);
+  for (int column = 0; column < width; ++column) {
+    buffer[column * 3] = pixels.red[column] & Mask;
+    buffer[column * 3 + 1] = pixels.green[column] & Mask;
+    buffer[column * 3 + 2] = pixels.blue[column] & Mask;
   }
 }
 
@@ -153,12 +207,32 @@ static void write_jpeg8(j_compress_ptr info_p, const Image *image) {
   }
 }
 
+// REQUIRES: info_p points to a valid jpeg_decompress_struct, with the
+//           header already read;
+//           0 <= min_width && 0 <= min_height
+// MODIFIES: *info_p
+// EFFECTS:  Sets the decode scale to 1/jpeg_scale_denom for the image's
+//           size and the given minimums.
+static void choose_jpeg_scale(j_decompress_ptr info_p, int min_width,
+                              int min_height) {
+  info_p->scale_num = 1;
+  info_p->scale_denom = jpeg_scale_denom(info_p->image_width,
+                                         info_p->image_height,
+                                         min_width, min_height);
+}
+
 // REQUIRES: image points to an Image object
+//           0 <= min_width && 0 <= min_height
 // MODIFIES: *image, cout
 // EFFECTS:  Reads a data from the JPEG file specified by the given
 //           filename into the given Image object.
+//           If min_width or min_height is positive, the image is
+//           decoded at the smallest of 1/8, 1/4 and 1/2 of its size
+//           that is still at least min_width wide and min_height
+//           tall, or at full size if none is.
 //           Returns whether or not the file was successfully read.
-bool read_jpeg(Image *image, const std::string &filename) {
+bool read_jpeg(Image *image, const std::string &filename, int min_width,
+               int min_height) {
   std::FILE *infile = std::fopen(filename.c_str(), "rb");
   if (!infile) {
     std::cout << "Failed to open " << filename << " for reading"
@@ -178,6 +252,7 @@ bool read_jpeg(Image *image, const std::string &filename) {
     return false;
   }
 
+  choose_jpeg_scale(&info, min_width, min_height);
   jpeg_start_decompress(&info);
   Image_init(image, info.output_width, info.output_height);
   if (info.data_precision != 8) {
@@ -255,7 +330,7 @@ static constexpr const char *MISSING_LIBJPEG =
 // MODIFIES: cout
 // EFFECTS:  Prints an error message with instructions of how to
 //           compile with libjpeg/libjpeg-turbo and returns false.
-bool read_jpeg(Image *, const std::string &) {
+bool read_jpeg(Image *, const std::string &, int, int) {
   std::cout << MISSING_LIBJPEG << std::endl;
   return false;
 }
@@ -0,0 +1,94 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+/* mapped_file.hpp
+ *
+ * Read-only access to the whole contents of a file, shared by the
+ * readers that parse files straight from memory. The file is
+ * memory-mapped on POSIX systems, so no copy of it is made, and read
+ * into a buffer elsewhere.
+ */
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MAPPED_FILE_USE_MMAP 0
+#endif
+
+// The contents of a file opened with MappedFile_open. data is valid
+// until MappedFile_close and may be null if the file is empty.
+struct MappedFile {
+  const unsigned char *data;
+  std::size_t size;
+  void *mapping;
+  std::vector<unsigned char> buffer;
+};
+
+// REQUIRES: file points to a MappedFile
+// MODIFIES: *file
+// EFFECTS:  Makes the contents of the given file available through file.
+//           Returns whether the file could be read.
+inline bool MappedFile_open(MappedFile *file, const std::string &filename) {
+  file->data = nullptr;
+  file->size = 0;
+  file->mapping = nullptr;
+#if MAPPED_FILE_USE_MMAP
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  file->size = st.st_size;
+  if (file->size > 0) {
+    void *mapping = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    file->mapping = mapping;
+    file->data = static_cast<const unsigned char *>(mapping);
+  }
+  close(fd);
+  return true;
+#else
+  std::ifstream input(filename, std::ios::binary);
+  if (!input.is_open()) {
+    return false;
+  }
+  file->buffer.assign(std::istreambuf_iterator<char>(input),
+                      std::istreambuf_iterator<char>());
+  file->data = file->buffer.data();
+  file->size = file->buffer.size();
+  return true;
+#endif
+}
+
+// REQUIRES: file points to a MappedFile opened with MappedFile_open
+// MODIFIES: *file
+// EFFECTS:  Releases the contents of the file.
+inline void MappedFile_close(MappedFile *file) {
+#if MAPPED_FILE_USE_MMAP
+  if (file->mapping) {
+    munmap(file->mapping, file->size);
+  }
+#endif
+  file->mapping = nullptr;
+  file->data = nullptr;
+  file->buffer.clear();
+}
+
+#endif // MAPPED_FILE_HPP
@@ -1,68 +1,208 @@
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 #include <vector>
 #include "processing.hpp"
+#include "simd.hpp"
 
 using namespace std;
 
-// v DO NOT CHANGE v ------------------------------------------------
-// The implementation of rotate_left is provided for you.
-// REQUIRES: img points to a valid Image
-// MODIFIES: *img
-// EFFECTS:  The image is rotated 90 degrees to the left (counterclockwise).
-void rotate_left(Image *img)
-{
+// Side length of the square tiles the rotations work in. One tile of
+// the source and one of the destination fit comfortably in L1, so the
+// column-order reads within a tile stay in cache.
+static const int ROTATE_TILE = 64;
 
-  // for convenience
-  int width = Image_width(img);
-  int height = Image_height(img);
+// A rotation of in, a width x height matrix, into out, a height x width
+// one, 90 degrees to the left if left is true and to the right otherwise.
+template <typename T>
+struct Rotation {
+  const T *in;
+  T *out;
+  int width;
+  int height;
+  bool left;
+};
 
-  // auxiliary image to temporarily store rotated image
-  Image aux;
-  Image_init(&aux, height, width); // width and height switched
+// The rows [r_begin, r_end) and columns [c_begin, c_end) of a matrix.
+struct Region {
+  int r_begin;
+  int r_end;
+  int c_begin;
+  int c_end;
+};
 
-  // iterate through pixels and place each where it goes in temp
-  for (int r = 0; r < height; ++r)
-  {
-    for (int c = 0; c < width; ++c)
-    {
-      Image_set_pixel(&aux, width - 1 - c, r, Image_get_pixel(img, r, c));
+// REQUIRES: tile lies within rot.out
+// MODIFIES: rot.out
+// EFFECTS:  Fills the given region of the output of the rotation.
+template <typename T>
+static void rotate_tile(const Rotation<T> &rot, const Region &tile) {
+  for (int r = tile.r_begin; r < tile.r_end; ++r) {
+    T *out_row = rot.out + (long long)r * rot.height;
+    if (rot.left) {
+      // out(r, c) = in(c, width - 1 - r)
+      const T *in_col = rot.in + (rot.width - 1 - r);
+      for (int c = tile.c_begin; c < tile.c_end; ++c) {
+        out_row[c] = in_col[(long long)c * rot.width];
+      }
+    } else {
+      // out(r, c) = in(height - 1 - c, r)
+      const T *in_col = rot.in + r;
+      for (int c = tile.c_begin; c < tile.c_end; ++c) {
+        out_row[c] = in_col[(long long)(rot.height - 1 - c) * rot.width];
+      }
     }
   }
+}
 
-  // Copy data back into original
-  *img = aux;
+// REQUIRES: region lies within rot.out
+// MODIFIES: rot.out
+// EFFECTS:  Fills the given region of the output of the rotation, one
+//           tile at a time.
+template <typename T>
+static void rotate_region(const Rotation<T> &rot, const Region &region) {
+  for (int r0 = region.r_begin; r0 < region.r_end; r0 += ROTATE_TILE) {
+    for (int c0 = region.c_begin; c0 < region.c_end; c0 += ROTATE_TILE) {
+      Region tile = { r0, min(r0 + ROTATE_TILE, region.r_end),
+                      c0, min(c0 + ROTATE_TILE, region.c_end) };
+      rotate_tile(rot, tile);
+    }
+  }
 }
-// ^ DO NOT CHANGE ^ ------------------------------------------------
 
-// v DO NOT CHANGE v ------------------------------------------------
-// The implementation of rotate_right is provided for you.
-// REQUIRES: img points to a valid Image.
-// MODIFIES: *img
-// EFFECTS:  The image is rotated 90 degrees to the right (clockwise).
-void rotate_right(Image *img)
-{
+#if SIMD_X86
+// MODIFIES: x
+// EFFECTS:  Transposes the 16x16 block of bytes whose rows are x[0], ...,
+//           x[15] by four rounds of byte interleaving, so that x[j] holds
+//           what was column j.
+__attribute__((target("sse2")))
+static void transpose_16x16(__m128i *x) {
+  __m128i z[16];
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      z[2 * i] = _mm_unpacklo_epi8(x[i], x[i + 8]);
+      z[2 * i + 1] = _mm_unpackhi_epi8(x[i], x[i + 8]);
+    }
+    for (int k = 0; k < 16; ++k) {
+      x[k] = z[k];
+    }
+  }
+}
 
-  // for convenience
-  int width = Image_width(img);
-  int height = Image_height(img);
+// REQUIRES: rows [r, r + 16) and columns [c, c + 16) lie within rot.out
+// MODIFIES: rot.out
+// EFFECTS:  Fills the 16x16 block of the output of the rotation at
+//           (r, c): the block is loaded as 16 rows, transposed in
+//           registers and stored as 16 rows in the order the rotation
+//           needs.
+__attribute__((target("sse2")))
+static void rotate_block_16x16(const Rotation<uint8_t> &rot, int r, int c) {
+  __m128i x[16];
+  // Row k of the block is the input row that becomes output column
+  // c + k, starting at the first column the rows [r, r + 16) of the
+  // output are taken from.
+  for (int k = 0; k < 16; ++k) {
+    const uint8_t *src = rot.left
+      ? rot.in + (long long)(c + k) * rot.width + (rot.width - 16 - r)
+      : rot.in + (long long)(rot.height - 1 - c - k) * rot.width + r;
+    x[k] = _mm_loadu_si128((const __m128i *)src);
+  }
+  transpose_16x16(x);
+  // x[j] now holds column j of the loaded block; a left rotation reads
+  // columns right to left.
+  for (int j = 0; j < 16; ++j) {
+    uint8_t *dst = rot.out + (long long)(r + j) * rot.height + c;
+    _mm_storeu_si128((__m128i *)dst, x[rot.left ? 15 - j : j]);
+  }
+}
+
+// REQUIRES: rows and cols are multiples of 16 with rows <= rot.width and
+//           cols <= rot.height
+// MODIFIES: rot.out
+// EFFECTS:  Same as rotate_region over [0, rows) x [0, cols), but moves
+//           16x16 blocks at a time.
+__attribute__((target("sse2")))
+static void rotate_region_sse2(const Rotation<uint8_t> &rot, int rows,
+                               int cols) {
+  for (int r0 = 0; r0 < rows; r0 += ROTATE_TILE) {
+    int r1 = min(r0 + ROTATE_TILE, rows);
+    for (int c0 = 0; c0 < cols; c0 += ROTATE_TILE) {
+      int c1 = min(c0 + ROTATE_TILE, cols);
+      for (int r = r0; r < r1; r += 16) {
+        for (int c = c0; c < c1; c += 16) {
+          rotate_block_16x16(rot, r, c);
+        }
+      }
+    }
+  }
+}
+#endif
 
-  // auxiliary image to temporarily store rotated image
-  Image aux;
-  Image_init(&aux, height, width); // width and height switched
+// REQUIRES: src points to a valid Matrix, dst points to a Matrix
+//           dst != src
+// MODIFIES: *dst
+// EFFECTS:  Sets *dst to src rotated 90 degrees to the left if left is
+//           true, and to the right otherwise. Every element of *dst is
+//           overwritten, so its existing storage is reused as is.
+template <typename T>
+static void rotate_matrix(const BasicMatrix<T> *src, BasicMatrix<T> *dst,
+                          bool left) {
+  int width = Matrix_width(src);
+  int height = Matrix_height(src);
+  dst->width = height;
+  dst->height = width;
+  dst->data.resize(src->data.size());
 
-  // iterate through pixels and place each where it goes in temp
-  for (int r = 0; r < height; ++r)
-  {
-    for (int c = 0; c < width; ++c)
-    {
-      Image_set_pixel(&aux, c, height - 1 - r, Image_get_pixel(img, r, c));
+  Rotation<T> rot = { src->data.data(), dst->data.data(), width, height,
+                      left };
+  // [0, rows) x [0, cols) of the output is done by the vector kernel,
+  // if there is one; the scalar loop covers the remaining strips.
+  int rows = 0;
+  int cols = 0;
+#if SIMD_X86
+  if constexpr (sizeof(T) == 1) {
+    if (simd_level() != SIMD_NONE) {
+      rows = width - width % 16;
+      cols = height - height % 16;
+      Rotation<uint8_t> bytes = {
+        reinterpret_cast<const uint8_t *>(rot.in),
+        reinterpret_cast<uint8_t *>(rot.out), width, height, left };
+      rotate_region_sse2(bytes, rows, cols);
     }
   }
+#endif
+  rotate_region(rot, { rows, width, 0, height });
+  rotate_region(rot, { 0, rows, cols, height });
+}
 
-  // Copy data back into original
-  *img = aux;
+// REQUIRES: img points to a valid Image
+// MODIFIES: *img
+// EFFECTS:  Rotates each channel of the image into a scratch matrix and
+//           swaps it in, so only one channel's worth of extra memory is
+//           used and nothing is copied back.
+static void rotate_image(Image *img, bool left) {
+  Matrix8 aux;
+  Matrix8 *channels[] = { &img->red_channel, &img->green_channel,
+                          &img->blue_channel };
+  for (Matrix8 *channel : channels) {
+    rotate_matrix(channel, &aux, left);
+    swap(*channel, aux);
+  }
+  swap(img->width, img->height);
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: *img
+// EFFECTS:  The image is rotated 90 degrees to the left (counterclockwise).
+void rotate_left(Image *img) {
+  rotate_image(img, true);
+}
+
+// REQUIRES: img points to a valid Image.
+// MODIFIES: *img
+// EFFECTS:  The image is rotated 90 degrees to the right (clockwise).
+void rotate_right(Image *img) {
+  rotate_image(img, false);
 }
-// ^ DO NOT CHANGE ^ ------------------------------------------------
 
 // v DO NOT CHANGE v ------------------------------------------------
 // The implementation of diff2 is provided for you.
@@ -80,6 +220,239 @@ static int squared_difference(Pixel p1, Pixel p2)
 // ------------------------------------------------------------------
 // You may change code below this line!
 
+// REQUIRES: img points to a valid Image
+//           0 < row < Image_height(img) - 1
+//           0 < column < Image_width(img) - 1
+// EFFECTS:  Returns the energy of the given interior pixel.
+template <typename Img>
+static int pixel_energy(const Img *img, int row, int column) {
+  Pixel p_left  = Image_get_pixel(img, row, column - 1);
+  Pixel p_right = Image_get_pixel(img, row, column + 1);
+  Pixel p_up    = Image_get_pixel(img, row - 1, column);
+  Pixel p_down  = Image_get_pixel(img, row + 1, column);
+  return squared_difference(p_left, p_right) + squared_difference(p_up, p_down);
+}
+
+// Energy row kernels
+// ------------------------------------------------------------------
+// The energy of an interior pixel only reads its row and the rows above
+// and below, so each row is computed from row pointers into the image.
+// For an Image with AVX2 available, 8 pixels are processed at a time
+// straight from the 8-bit channel rows. The division by 100 in
+// squared_difference is replaced by an exact multiply and shift, and the
+// row maximum is accumulated in the same pass.
+
+// The same row of the three channels of an Image, read-only.
+using ChannelRows = ImageRow<const uint8_t>;
+
+// An energy row being computed: its elements, the width of the image
+// and the largest energy computed so far.
+template <typename E>
+struct EnergyRowOut {
+  E *data;
+  int width;
+  int max_energy;
+};
+
+// EFFECTS:  Returns the pixel at the given column of the rows.
+static Pixel pixel_at(const ChannelRows &rows, int column) {
+  return { rows.red[column], rows.green[column], rows.blue[column] };
+}
+
+#if SIMD_X86
+
+// REQUIRES: each lane of x is in [0, 3 * 255 * 255]
+// EFFECTS:  Returns x / 100 in each lane, computed as (x * 167773) >> 24.
+//           The multiplier is ceil(2^24 / 100); its error is small enough
+//           that the result is exact over the whole required range.
+__attribute__((target("avx2")))
+static inline __m256i div100_lanes(__m256i x) {
+  const __m256i m = _mm256_set1_epi32(167773);
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, m), 24);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+  odd = _mm256_slli_epi64(_mm256_srli_epi64(odd, 24), 32);
+  return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+// EFFECTS:  Returns the sum of the squared differences of the 8-bit
+//           values at a and b, widened to 32-bit lanes, added to acc.
+__attribute__((target("avx2")))
+static inline __m256i add_squared_diff8(__m256i acc, const uint8_t *a,
+                                        const uint8_t *b) {
+  __m256i va = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)a));
+  __m256i vb = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)b));
+  __m256i d = _mm256_sub_epi32(vb, va);
+  return _mm256_add_epi32(acc, _mm256_mullo_epi32(d, d));
+}
+
+// EFFECTS:  Stores 8 energies, narrowing them to the element type.
+__attribute__((target("avx2")))
+static inline void store_energy8(int *out, __m256i v) {
+  _mm256_storeu_si256((__m256i*)out, v);
+}
+__attribute__((target("avx2")))
+static inline void store_energy8(uint16_t *out, __m256i v) {
+  __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0xD8);
+  _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(packed));
+}
+
+// REQUIRES: up, mid and down are consecutive rows of an Image of width
+//           out->width
+//           out->data points to the energy row for mid
+// MODIFIES: out->data[1], ..., out->data[j - 1] for the returned j,
+//           out->max_energy
+// EFFECTS:  Computes interior energies starting at column 1 in blocks of
+//           8, raising out->max_energy to the largest one computed, and
+//           returns the first column not computed.
+template <typename E>
+__attribute__((target("avx2")))
+static int energy_row_avx2(const ChannelRows &up, const ChannelRows &mid,
+                           const ChannelRows &down, EnergyRowOut<E> *out) {
+  int w = out->width;
+  __m256i max_lanes = _mm256_set1_epi32(out->max_energy);
+  int j = 1;
+  for (; j + 8 <= w - 1; j += 8) {
+    __m256i dx = _mm256_setzero_si256();
+    dx = add_squared_diff8(dx, mid.red.data + j - 1, mid.red.data + j + 1);
+    dx = add_squared_diff8(dx, mid.green.data + j - 1, mid.green.data + j + 1);
+    dx = add_squared_diff8(dx, mid.blue.data + j - 1, mid.blue.data + j + 1);
+    __m256i dy = _mm256_setzero_si256();
+    dy = add_squared_diff8(dy, up.red.data + j, down.red.data + j);
+    dy = add_squared_diff8(dy, up.green.data + j, down.green.data + j);
+    dy = add_squared_diff8(dy, up.blue.data + j, down.blue.data + j);
+    __m256i val = _mm256_add_epi32(div100_lanes(dx), div100_lanes(dy));
+    max_lanes = _mm256_max_epi32(max_lanes, val);
+    store_energy8(out->data + j, val);
+  }
+  int lanes[8];
+  _mm256_storeu_si256((__m256i*)lanes, max_lanes);
+  for (int lane : lanes) {
+    out->max_energy = max(out->max_energy, lane);
+  }
+  return j;
+}
+
+#endif // SIMD_X86
+
+// REQUIRES: img points to a valid Image, 1 <= row < Image_height(img) - 1
+//           out points to the energy row for row
+// MODIFIES: out[1], ..., out[Image_width(img) - 2]
+// EFFECTS:  Computes the interior energies of the given row and returns
+//           the largest of them, or 0 if there are none.
+template <typename E>
+static int energy_row(const Image *img, int row, E *out) {
+  ChannelRows up = Image_row(img, row - 1);
+  ChannelRows mid = Image_row(img, row);
+  ChannelRows down = Image_row(img, row + 1);
+  EnergyRowOut<E> row_out = { out, Image_width(img), 0 };
+
+  int j = 1;
+#if SIMD_X86
+  if (simd_level() == SIMD_AVX2) {
+    j = energy_row_avx2(up, mid, down, &row_out);
+  }
+#endif
+  for (; j < row_out.width - 1; ++j) {
+    int val = squared_difference(pixel_at(mid, j - 1), pixel_at(mid, j + 1))
+              + squared_difference(pixel_at(up, j), pixel_at(down, j));
+    out[j] = val;
+    row_out.max_energy = max(row_out.max_energy, val);
+  }
+  return row_out.max_energy;
+}
+
+// REQUIRES: mid is a row of w interleaved pixels, with rows of them
+//           stride bytes before and after it
+//           out points to the energy row for mid
+// MODIFIES: out[1], ..., out[w - 2]
+// EFFECTS:  Computes the interior energies of the row mid and returns
+//           the largest of them, or 0 if there are none.
+template <typename E>
+static int interleaved_energy_row(const uint8_t *mid, ptrdiff_t stride,
+                                  int w, E *out) {
+  const uint8_t *up = mid - stride;
+  const uint8_t *down = mid + stride;
+  int max_energy = 0;
+
+  for (int j = 1; j < w - 1; ++j) {
+    const uint8_t *l = mid + 3 * (j - 1);
+    const uint8_t *r = mid + 3 * (j + 1);
+    const uint8_t *u = up + 3 * j;
+    const uint8_t *d = down + 3 * j;
+    int val = squared_difference({l[0], l[1], l[2]}, {r[0], r[1], r[2]})
+              + squared_difference({u[0], u[1], u[2]}, {d[0], d[1], d[2]});
+    out[j] = val;
+    max_energy = max(max_energy, val);
+  }
+  return max_energy;
+}
+
+// REQUIRES: img points to a valid PackedImage,
+//           1 <= row < Image_height(img) - 1
+//           out points to the energy row for row
+// MODIFIES: out[1], ..., out[Image_width(img) - 2]
+// EFFECTS:  Computes the interior energies of the given row and returns
+//           the largest of them, or 0 if there are none.
+template <typename E>
+static int energy_row(const PackedImage *img, int row, E *out) {
+  int w = Image_width(img);
+  const uint8_t *mid = &img->data[3 * (long long)row * w];
+  return interleaved_energy_row(mid, 3 * (ptrdiff_t)w, w, out);
+}
+
+// REQUIRES: img points to a valid ImageView,
+//           1 <= row < Image_height(img) - 1
+//           out points to the energy row for row
+// MODIFIES: out[1], ..., out[Image_width(img) - 2]
+// EFFECTS:  Computes the interior energies of the given row and returns
+//           the largest of them, or 0 if there are none.
+template <typename E>
+static int energy_row(const ImageView *img, int row, E *out) {
+  const uint8_t *mid = img->data + row * img->stride;
+  return interleaved_energy_row(mid, img->stride, Image_width(img), out);
+}
+
+// ------------------------------------------------------------------
+
+// REQUIRES: energy points to a valid Matrix or MatrixView
+// MODIFIES: *energy
+// EFFECTS:  Sets the first/last row and first/last column to value.
+//           Unlike Matrix_fill_border, only the border is visited.
+template <typename M>
+static void fill_energy_border(M *energy, int value) {
+  int h = Matrix_height(energy);
+  int w = Matrix_width(energy);
+  auto top = Matrix_row(energy, 0);
+  auto bottom = Matrix_row(energy, h - 1);
+  for (int i = 0; i < w; ++i) {
+    top[i] = value;
+    bottom[i] = value;
+  }
+  for (int i = 0; i < h; ++i) {
+    auto row = Matrix_row(energy, i);
+    row[0] = value;
+    row[w - 1] = value;
+  }
+}
+
+// REQUIRES: img points to a valid Image
+//           energy points to a Matrix or MatrixView of the same size
+// MODIFIES: *energy
+// EFFECTS:  Computes the energy matrix of the image into energy.
+template <typename Img, typename M>
+static void fill_energy(const Img *img, M *energy) {
+  int h = Image_height(img);
+  int max_energy = 0;
+
+  for (int i = 1; i < h - 1; ++i) {
+    int row_max = energy_row(img, i, Matrix_row(energy, i).data);
+    if (row_max > max_energy) {
+      max_energy = row_max;
+    }
+  }
+  fill_energy_border(energy, max_energy);
+}
+
 // REQUIRES: img points to a valid Image.
 //           energy points to a Matrix.
 // MODIFIES: *energy
@@ -88,33 +461,376 @@ static int squared_difference(Pixel p1, Pixel p2)
 //           size as the given Image, and then the energy matrix for that
 //           image is computed and written into it.
 //           See the project spec for details on computing the energy matrix.
-void compute_energy_matrix(const Image *img, Matrix *energy) {
-  int h = Image_height(img);
-  int w = Image_width(img);
-  Matrix_init(energy, w, h);
-  int max_energy = 0;
+template <typename Img, typename E>
+void compute_energy_matrix(const Img *img, BasicMatrix<E> *energy) {
+  Matrix_init(energy, Image_width(img), Image_height(img));
+  fill_energy(img, energy);
+}
 
+// REQUIRES: img points to a valid Image
+//           energy points to a valid MatrixView of the same size
+// MODIFIES: the elements viewed by energy
+// EFFECTS:  Computes the energy matrix of the image into the view,
+//           exactly as compute_energy_matrix(img, matrix) does.
+template <typename Img, typename E>
+void compute_energy_matrix(const Img *img, MatrixView<E> *energy) {
+  fill_energy(img, energy);
+}
+
+// Rows of pixels stored back to back, each pixel group elements long,
+// as in a Matrix (1) or a PackedImage (3).
+template <typename T>
+struct PixelRows {
+  T *data;
+  int width;
+  int group;
+};
+
+// REQUIRES: the rows before the given row have already been shifted
+//           0 <= column < rows.width
+// MODIFIES: rows.data
+// EFFECTS:  Moves the given row to its place in rows one pixel narrower,
+//           dropping the pixel at column, and returns a pointer to the
+//           moved row. Rows only move towards the front of the buffer,
+//           so shifting them in order never overwrites a row that has
+//           not been moved yet.
+template <typename T>
+static T *shift_row_past_seam(const PixelRows<T> &rows, int row,
+                              int column) {
+  int group = rows.group;
+  T *old_row = rows.data + (long long)row * rows.width * group;
+  T *new_row = rows.data + (long long)row * (rows.width - 1) * group;
+  memmove(new_row, old_row, column * group * sizeof(T));
+  memmove(new_row + column * group, old_row + (column + 1) * group,
+          (rows.width - column - 1) * group * sizeof(T));
+  return new_row;
+}
+
+// REQUIRES: rows holds height rows
+//           seam has rows.width elements, each in [0, height)
+// MODIFIES: rows.data
+// EFFECTS:  Removes pixel (seam[c], c) from each column c, moving the
+//           pixels below it up by one row. Rows are visited top to bottom,
+//           so every access is sequential and each row only reads the
+//           unmodified row below it.
+template <typename T>
+static void shift_rows_past_seam(const PixelRows<T> &rows, int height,
+                                 const vector<int> &seam) {
+  int group = rows.group;
+  long long row_size = (long long)rows.width * group;
+  // Rows above the seam's highest point keep their pixels, and every
+  // row past its lowest point moves up whole, so only the band in
+  // between needs a per-pixel select.
+  int lo = *min_element(seam.begin(), seam.end());
+  int hi = *max_element(seam.begin(), seam.end());
+  for (int i = lo; i < hi; ++i) {
+    T *row = rows.data + i * row_size;
+    // Copy up each run of columns whose seam pixel is at or above row i.
+    for (int j = 0; j < rows.width;) {
+      if (seam[j] > i) {
+        ++j;
+        continue;
+      }
+      int end = j + 1;
+      while (end < rows.width && seam[end] <= i) {
+        ++end;
+      }
+      memcpy(row + j * group, row + row_size + j * group,
+             (end - j) * group * sizeof(T));
+      j = end;
+    }
+  }
+  memmove(rows.data + hi * row_size, rows.data + (hi + 1) * row_size,
+          (height - 1 - hi) * row_size * sizeof(T));
+}
+
+// The largest possible energy: two squared differences of at most
+// 3 * 255 * 255 / 100 each.
+static const int MAX_ENERGY = 2 * (3 * MAX_INTENSITY * MAX_INTENSITY / 100);
+
+// REQUIRES: ie points to an IncrementalEnergy
+//           img points to a valid Image
+// MODIFIES: *ie
+// EFFECTS:  Initializes ie->energy to the energy matrix of the image,
+//           exactly as compute_energy_matrix does.
+template <typename Img>
+void IncrementalEnergy_init(IncrementalEnergy *ie, const Img *img) {
+  compute_energy_matrix(img, &ie->energy);
+  ie->histogram.assign(MAX_ENERGY + 1, 0);
+  ie->max_energy = 0;
+
+  int h = Matrix_height(&ie->energy);
+  int w = Matrix_width(&ie->energy);
+  int *histogram = ie->histogram.data();
+  int top = 0;
   for (int i = 1; i < h - 1; ++i) {
+    RowSpan<uint16_t> row = Matrix_row(&ie->energy, i);
     for (int j = 1; j < w - 1; ++j) {
-      Pixel p_left  = Image_get_pixel(img, i, j - 1);
-      Pixel p_right = Image_get_pixel(img, i, j + 1);
-      Pixel p_up    = Image_get_pixel(img, i - 1, j);
-      Pixel p_down  = Image_get_pixel(img, i + 1, j);
-      int val = squared_difference(p_left, p_right) + squared_difference(p_up, p_down);
-      *Matrix_at(energy, i, j) = val;
-      if (val > max_energy) {
-        max_energy = val;
+      ++histogram[row[j]];
+      top = max(top, (int)row[j]);
+    }
+  }
+  ie->max_energy = top;
+}
+
+// REQUIRES: ie points to a valid IncrementalEnergy for an image
+//           img points to that image after remove_vertical_seam(img, seam)
+// MODIFIES: *ie
+// EFFECTS:  Updates ie->energy to the energy matrix of the carved image,
+//           recomputing only the pixels next to the seam and the border.
+// NOTE:     In row i, a pixel's energy can only change if one of its
+//           neighbors moved relative to it, which is limited to columns
+//           near seam[i - 1], seam[i] and seam[i + 1]. Those columns are
+//           removed from the histogram, the row is shifted left past the
+//           seam, and the same columns are recomputed and added back.
+template <typename Img>
+void IncrementalEnergy_remove_vertical_seam(IncrementalEnergy *ie,
+                                            const Img *img,
+                                            const vector<int> &seam) {
+  int h = Image_height(img);
+  int w = Image_width(img);
+  int old_w = w + 1;
+  vector<int> &histogram = ie->histogram;
+  int top = ie->max_energy;
+  PixelRows<uint16_t> rows = { ie->energy.data.data(), old_w, 1 };
+
+  for (int i = 0; i < h; ++i) {
+    int lo = seam[i];
+    int hi = seam[i];
+    if (i > 0) {
+      lo = min(lo, seam[i - 1]);
+      hi = max(hi, seam[i - 1]);
+    }
+    if (i < h - 1) {
+      lo = min(lo, seam[i + 1]);
+      hi = max(hi, seam[i + 1]);
+    }
+    lo = max(lo - 1, 1);
+    hi = hi + 1;
+    bool interior_row = 0 < i && i < h - 1;
+
+    uint16_t *old_row = ie->energy.data.data() + (long long)i * old_w;
+    if (interior_row) {
+      for (int j = lo; j <= min(hi, old_w - 2); ++j) {
+        --histogram[old_row[j]];
+      }
+    }
+
+    uint16_t *new_row = shift_row_past_seam(rows, i, seam[i]);
+
+    if (interior_row) {
+      for (int j = lo; j <= min(hi - 1, w - 2); ++j) {
+        int val = pixel_energy(img, i, j);
+        new_row[j] = val;
+        ++histogram[val];
+        top = max(top, val);
       }
     }
   }
 
+  ie->energy.width = w;
+  ie->energy.data.resize((long long)w * h);
+  while (top > 0 && histogram[top] == 0) {
+    --top;
+  }
+  ie->max_energy = top;
+  fill_energy_border(&ie->energy, top);
+}
+
+// REQUIRES: 0 <= k < seam.size()
+// MODIFIES: *lo, *hi
+// EFFECTS:  Sets [lo, hi] to the pixels along line k of the image (a
+//           column for a horizontal seam) whose energy may change when the
+//           seam is removed, as positions before the removal: one before
+//           the nearest of seam[k - 1], seam[k] and seam[k + 1], but at
+//           least 1, through one past the farthest.
+static void seam_neighborhood(const vector<int> &seam, int k, int *lo,
+                              int *hi) {
+  int n = seam.size();
+  int first = seam[k];
+  int last = seam[k];
+  if (k > 0) {
+    first = min(first, seam[k - 1]);
+    last = max(last, seam[k - 1]);
+  }
+  if (k < n - 1) {
+    first = min(first, seam[k + 1]);
+    last = max(last, seam[k + 1]);
+  }
+  *lo = max(first - 1, 1);
+  *hi = last + 1;
+}
+
+// REQUIRES: ie points to a valid IncrementalEnergy for an image
+//           img points to that image after remove_horizontal_seam(img, seam)
+// MODIFIES: *ie
+// EFFECTS:  Updates ie->energy to the energy matrix of the carved image,
+//           recomputing only the pixels next to the seam and the border.
+// NOTE:     The transpose of IncrementalEnergy_remove_vertical_seam: in
+//           column j, only rows near seam[j - 1], seam[j] and seam[j + 1]
+//           can change. They are removed from the histogram, the matrix
+//           rows are shifted up past the seam, and the same rows are
+//           recomputed and added back.
+template <typename Img>
+void IncrementalEnergy_remove_horizontal_seam(IncrementalEnergy *ie,
+                                              const Img *img,
+                                              const vector<int> &seam) {
+  int h = Image_height(img);
+  int w = Image_width(img);
+  int old_h = h + 1;
+  vector<int> &histogram = ie->histogram;
+  int top = ie->max_energy;
+  uint16_t *energy = ie->energy.data.data();
+  int lo, hi;
+
+  for (int j = 1; j < w - 1; ++j) {
+    seam_neighborhood(seam, j, &lo, &hi);
+    for (int i = lo; i <= min(hi, old_h - 2); ++i) {
+      --histogram[energy[(long long)i * w + j]];
+    }
+  }
+
+  PixelRows<uint16_t> rows = { energy, w, 1 };
+  shift_rows_past_seam(rows, old_h, seam);
+  ie->energy.height = h;
+  ie->energy.data.resize((long long)w * h);
+
+  for (int j = 1; j < w - 1; ++j) {
+    seam_neighborhood(seam, j, &lo, &hi);
+    for (int i = lo; i <= min(hi - 1, h - 2); ++i) {
+      int val = pixel_energy(img, i, j);
+      energy[(long long)i * w + j] = val;
+      ++histogram[val];
+      top = max(top, val);
+    }
+  }
+
+  while (top > 0 && histogram[top] == 0) {
+    --top;
+  }
+  ie->max_energy = top;
+  fill_energy_border(&ie->energy, top);
+}
+
+// Cost row kernels
+// ------------------------------------------------------------------
+// Each row of the vertical cost matrix depends only on the row above:
+//   cost[j] = energy[j] + min(prev[j - 1], prev[j], prev[j + 1])
+// The edge columns have only two candidates and are handled separately
+// so that the interior loop is branch-free. For 32-bit cost types the
+// interior is computed with AVX2 or SSE4.1 (see simd.hpp).
+
+#if SIMD_X86
+
+// EFFECTS:  Loads 8 (AVX2) or 4 (SSE4.1) energies widened to 32 bits.
+__attribute__((target("avx2")))
+static inline __m256i load_energy8(const int *p) {
+  return _mm256_loadu_si256((const __m256i*)p);
+}
+__attribute__((target("avx2")))
+static inline __m256i load_energy8(const uint16_t *p) {
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+__attribute__((target("sse4.1")))
+static inline __m128i load_energy4(const int *p) {
+  return _mm_loadu_si128((const __m128i*)p);
+}
+__attribute__((target("sse4.1")))
+static inline __m128i load_energy4(const uint16_t *p) {
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+// REQUIRES: energy, prev and out point to rows of width w
+// MODIFIES: out[1], ..., out[j - 1] for the returned j
+// EFFECTS:  Computes interior cost entries starting at column 1 in
+//           blocks of 8 and returns the first column not computed.
+template <typename E, typename C>
+__attribute__((target("avx2")))
+static int cost_row_avx2(const E *energy, const C *prev, C *out, int w) {
+  int j = 1;
+  for (; j + 8 <= w - 1; j += 8) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(prev + j - 1));
+    __m256i mid = _mm256_loadu_si256((const __m256i*)(prev + j));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(prev + j + 1));
+    __m256i best = min_lanes(min_lanes(left, mid, prev), right, prev);
+    __m256i sum = _mm256_add_epi32(load_energy8(energy + j), best);
+    _mm256_storeu_si256((__m256i*)(out + j), sum);
+  }
+  return j;
+}
+
+// REQUIRES: energy, prev and out point to rows of width w
+// MODIFIES: out[1], ..., out[j - 1] for the returned j
+// EFFECTS:  Computes interior cost entries starting at column 1 in
+//           blocks of 4 and returns the first column not computed.
+template <typename E, typename C>
+__attribute__((target("sse4.1")))
+static int cost_row_sse41(const E *energy, const C *prev, C *out, int w) {
+  int j = 1;
+  for (; j + 4 <= w - 1; j += 4) {
+    __m128i left = _mm_loadu_si128((const __m128i*)(prev + j - 1));
+    __m128i mid = _mm_loadu_si128((const __m128i*)(prev + j));
+    __m128i right = _mm_loadu_si128((const __m128i*)(prev + j + 1));
+    __m128i best = min_lanes(min_lanes(left, mid, prev), right, prev);
+    __m128i sum = _mm_add_epi32(load_energy4(energy + j), best);
+    _mm_storeu_si128((__m128i*)(out + j), sum);
+  }
+  return j;
+}
+
+#endif // SIMD_X86
+
+// REQUIRES: energy, prev and out point to rows of width w, w > 0
+// MODIFIES: out[0], ..., out[w - 1]
+// EFFECTS:  Computes one row of the vertical cost matrix from the row
+//           of energies and the previous row of costs.
+template <typename E, typename C>
+static void cost_row(const E *energy, const C *prev, C *out, int w) {
+  if (w == 1) {
+    out[0] = energy[0] + prev[0];
+    return;
+  }
+  out[0] = energy[0] + min(prev[0], prev[1]);
+  out[w - 1] = energy[w - 1] + min(prev[w - 2], prev[w - 1]);
+
+  int j = 1;
+#if SIMD_X86
+  if constexpr (sizeof(C) == 4) {
+    switch (simd_level()) {
+    case SIMD_AVX2:
+      j = cost_row_avx2(energy, prev, out, w);
+      break;
+    case SIMD_SSE41:
+      j = cost_row_sse41(energy, prev, out, w);
+      break;
+    case SIMD_NONE:
+      break;
+    }
+  }
+#endif
+  for (; j < w - 1; ++j) {
+    out[j] = energy[j] + min(min(prev[j - 1], prev[j]), prev[j + 1]);
+  }
+}
+// ------------------------------------------------------------------
+
+// REQUIRES: energy points to a valid Matrix or MatrixView
+//           cost points to a Matrix or MatrixView of the same size
+//           energy and cost don't hold the same elements
+// MODIFIES: *cost
+// EFFECTS:  Computes the vertical cost matrix of energy into cost.
+template <typename EM, typename CM>
+static void fill_vertical_cost(const EM *energy, CM *cost) {
+  int h = Matrix_height(energy);
+  int w = Matrix_width(energy);
+  auto energy_top = Matrix_row(energy, 0);
+  auto cost_top = Matrix_row(cost, 0);
   for (int i = 0; i < w; ++i) {
-    *Matrix_at(energy, 0, i) = max_energy;
-    *Matrix_at(energy, h - 1, i) = max_energy;
+    cost_top[i] = energy_top[i];
   }
-  for (int i = 0; i < h; ++i) {
-    *Matrix_at(energy, i, 0) = max_energy;
-    *Matrix_at(energy, i, w - 1) = max_energy;
+  for (int i = 1; i < h; ++i) {
+    cost_row(Matrix_row(energy, i).data, Matrix_row(cost, i - 1).data,
+             Matrix_row(cost, i).data, w);
   }
 }
 
@@ -127,26 +843,206 @@ void compute_energy_matrix(const Image *img, Matrix *energy) {
 //           size as the given energy Matrix, and then the cost matrix is
 //           computed and written into it.
 //           See the project spec for details on computing the cost matrix.
-void compute_vertical_cost_matrix(const Matrix *energy, Matrix *cost) {
+template <typename E, typename C>
+void compute_vertical_cost_matrix(const BasicMatrix<E> *energy,
+                                  BasicMatrix<C> *cost) {
+  Matrix_init(cost, Matrix_width(energy), Matrix_height(energy));
+  fill_vertical_cost(energy, cost);
+}
+
+// REQUIRES: energy points to a valid MatrixView
+//           cost points to a valid MatrixView of the same size
+//           energy and cost don't view the same elements
+// MODIFIES: the elements viewed by cost
+// EFFECTS:  Computes the vertical cost matrix of energy into the view,
+//           exactly as compute_vertical_cost_matrix(energy, matrix) does.
+template <typename E, typename C>
+void compute_vertical_cost_matrix(const MatrixView<E> *energy,
+                                  MatrixView<C> *cost) {
+  fill_vertical_cost(energy, cost);
+}
+
+// REQUIRES: cost points to the vertical cost matrix of an energy matrix
+//           energy points to that energy matrix after the given vertical
+//           seam was removed, where only pixels next to the seam changed
+//           and the border value did not change (as is the case after
+//           IncrementalEnergy_remove_vertical_seam if max_energy is the
+//           same as before)
+// MODIFIES: *cost
+// EFFECTS:  Updates cost to the vertical cost matrix of energy, exactly as
+//           compute_vertical_cost_matrix would compute it. Each row is
+//           shifted left past the seam, and only entries near the seam or
+//           below an entry that changed in the row above are recomputed.
+// NOTE:     In row i, an entry can differ from its shifted old value only
+//           if its energy changed or its parents moved relative to it,
+//           both limited to columns near seam[i - 1], seam[i] and
+//           seam[i + 1], or if one of its parents changed. Recomputed
+//           entries that come out the same stop propagating, so the
+//           region shrinks again once the seam's influence dies out.
+template <typename E, typename C>
+void update_vertical_cost_matrix(const BasicMatrix<E> *energy,
+                                 BasicMatrix<C> *cost,
+                                 const vector<int> &seam) {
   int h = Matrix_height(energy);
   int w = Matrix_width(energy);
-  Matrix_init(cost, w, h);
+  int old_w = w + 1;
+  // columns that changed in the previous row, empty if lo > hi
+  int changed_lo = 0;
+  int changed_hi = -1;
+  PixelRows<C> rows = { cost->data.data(), old_w, 1 };
 
-  for (int i = 0; i < w; ++i) {
-    *Matrix_at(cost, 0, i) = *Matrix_at(energy, 0, i);
-  }
-  for (int i = 1; i < h; ++i) {
-    for (int j = 0; j < w; ++j) {
-      int best = *Matrix_at(cost, i - 1, j);
+  for (int i = 0; i < h; ++i) {
+    C *row = shift_row_past_seam(rows, i, seam[i]);
+    if (i == 0) {
+      // The first row is the energy border, which did not change.
+      continue;
+    }
+
+    int lo = min(seam[i - 1], seam[i]);
+    int hi = max(seam[i - 1], seam[i]);
+    if (i < h - 1) {
+      lo = min(lo, seam[i + 1]);
+      hi = max(hi, seam[i + 1]);
+    }
+    lo = lo - 1;
+    if (changed_lo <= changed_hi) {
+      lo = min(lo, changed_lo - 1);
+      hi = max(hi, changed_hi + 1);
+    }
+    lo = max(lo, 0);
+    hi = min(hi, w - 1);
+
+    const C *prev = row - w;
+    const E *energy_row = Matrix_row(energy, i).data;
+    changed_lo = w;
+    changed_hi = -1;
+    for (int j = lo; j <= hi; ++j) {
+      C best = prev[j];
       if (j > 0) {
-        int candidate = *Matrix_at(cost, i - 1, j - 1);
-        if (candidate < best) best = candidate;
+        best = min(best, prev[j - 1]);
       }
       if (j < w - 1) {
-        int candidate = *Matrix_at(cost, i - 1, j + 1);
-        if (candidate < best) best = candidate;
+        best = min(best, prev[j + 1]);
+      }
+      C val = energy_row[j] + best;
+      if (val != row[j]) {
+        row[j] = val;
+        changed_lo = min(changed_lo, j);
+        changed_hi = j;
+      }
+    }
+  }
+
+  cost->width = w;
+  cost->data.resize((long long)w * h);
+}
+
+// REQUIRES: energy points to a valid Matrix.
+//           cost points to a Matrix.
+//           energy and cost aren't pointing to the same Matrix
+// MODIFIES: *cost
+// EFFECTS:  cost serves as an "output parameter".
+//           The Matrix pointed to by cost is initialized to be the same
+//           size as the given energy Matrix, and then the horizontal cost
+//           matrix is computed and written into it. The last column is
+//           the energy, and each entry of the other columns is its energy
+//           plus the minimal cost among the (up to) three entries above,
+//           beside and below it in the column to its right. This is the
+//           vertical cost matrix of the image rotated 90 degrees left,
+//           stored unrotated.
+// NOTE:     Each column depends on the one to its right, so the columns
+//           are computed right to left, each from the top down. Adjacent
+//           columns share cache lines, so the working set is about two
+//           lines per row and the matrices are never transposed.
+template <typename E, typename C>
+void compute_horizontal_cost_matrix(const BasicMatrix<E> *energy,
+                                    BasicMatrix<C> *cost) {
+  int h = Matrix_height(energy);
+  int w = Matrix_width(energy);
+  Matrix_init(cost, w, h);
+  const E *e = energy->data.data();
+  C *c = cost->data.data();
+
+  for (int i = 0; i < h; ++i) {
+    c[(long long)i * w + w - 1] = e[(long long)i * w + w - 1];
+  }
+  for (int j = w - 2; j >= 0; --j) {
+    for (int i = 0; i < h; ++i) {
+      const C *next = c + (long long)i * w + j + 1;
+      C best = *next;
+      if (i > 0) {
+        best = min(best, *(next - w));
+      }
+      if (i < h - 1) {
+        best = min(best, *(next + w));
+      }
+      c[(long long)i * w + j] = e[(long long)i * w + j] + best;
+    }
+  }
+}
+
+// REQUIRES: cost points to the horizontal cost matrix of an energy matrix
+//           energy points to that energy matrix after the given horizontal
+//           seam was removed, where only pixels next to the seam changed
+//           and the border value did not change (as is the case after
+//           IncrementalEnergy_remove_horizontal_seam if max_energy is the
+//           same as before)
+// MODIFIES: *cost
+// EFFECTS:  Updates cost to the horizontal cost matrix of energy, exactly
+//           as compute_horizontal_cost_matrix would compute it. The rows
+//           are shifted up past the seam, and then, from the right, only
+//           entries near the seam or beside an entry that changed in the
+//           column to the right are recomputed.
+// NOTE:     The transpose of update_vertical_cost_matrix.
+template <typename E, typename C>
+void update_horizontal_cost_matrix(const BasicMatrix<E> *energy,
+                                   BasicMatrix<C> *cost,
+                                   const vector<int> &seam) {
+  int h = Matrix_height(energy);
+  int w = Matrix_width(energy);
+  PixelRows<C> rows = { cost->data.data(), w, 1 };
+  shift_rows_past_seam(rows, h + 1, seam);
+  cost->height = h;
+  cost->data.resize((long long)w * h);
+
+  const E *e = energy->data.data();
+  C *c = cost->data.data();
+  // rows that changed in the column to the right, empty if lo > hi
+  int changed_lo = 0;
+  int changed_hi = -1;
+  // The last column is the energy border, which did not change.
+  for (int j = w - 2; j >= 0; --j) {
+    int lo = min(seam[j + 1], seam[j]);
+    int hi = max(seam[j + 1], seam[j]);
+    if (j > 0) {
+      lo = min(lo, seam[j - 1]);
+      hi = max(hi, seam[j - 1]);
+    }
+    lo = lo - 1;
+    if (changed_lo <= changed_hi) {
+      lo = min(lo, changed_lo - 1);
+      hi = max(hi, changed_hi + 1);
+    }
+    lo = max(lo, 0);
+    hi = min(hi, h - 1);
+
+    changed_lo = h;
+    changed_hi = -1;
+    for (int i = lo; i <= hi; ++i) {
+      const C *next = c + (long long)i * w + j + 1;
+      C best = *next;
+      if (i > 0) {
+        best = min(best, *(next - w));
+      }
+      if (i < h - 1) {
+        best = min(best, *(next + w));
+      }
+      C val = e[(long long)i * w + j] + best;
+      if (val != next[-1]) {
+        c[(long long)i * w + j] = val;
+        changed_lo = min(changed_lo, i);
+        changed_hi = i;
       }
-      *Matrix_at(cost, i, j) = *Matrix_at(energy, i, j) + best;
     }
   }
 }
@@ -162,10 +1058,22 @@ void compute_vertical_cost_matrix(const Matrix *energy, Matrix *cost) {
 //           See the project spec for details on computing the minimal seam.
 //           Note: When implementing the algorithm, compute the seam starting at the
 //           bottom row and work your way up.
-vector<int> find_minimal_vertical_seam(const Matrix *cost) {
+template <typename C>
+vector<int> find_minimal_vertical_seam(const BasicMatrix<C> *cost) {
+  vector<int> seam(Matrix_height(cost));
+  find_minimal_vertical_seam(cost, seam.data());
+  return seam;
+}
+
+// REQUIRES: cost points to a valid Matrix
+//           seam points to an array of Matrix_height(cost) ints
+// MODIFIES: seam[0], ..., seam[Matrix_height(cost) - 1]
+// EFFECTS:  Same as find_minimal_vertical_seam(cost), but writes the seam
+//           into the given array instead of returning a new vector.
+template <typename C>
+void find_minimal_vertical_seam(const BasicMatrix<C> *cost, int *seam) {
   int h = Matrix_height(cost);
   int w = Matrix_width(cost);
-  vector<int> seam(h);
   int col = Matrix_column_of_min_value_in_row(cost, h - 1, 0, w);
   seam[h - 1] = col;
 
@@ -181,9 +1089,68 @@ vector<int> find_minimal_vertical_seam(const Matrix *cost) {
     col = Matrix_column_of_min_value_in_row(cost, i, start, end);
     seam[i] = col;
   }
+}
+
+// REQUIRES: mat points to a valid Matrix
+//           0 <= column && column < Matrix_width(mat)
+//           0 <= row_start && row_end <= Matrix_height(mat)
+//           row_start < row_end
+// EFFECTS:  Returns the row of the topmost minimal element in the given
+//           column between row_start (inclusive) and row_end (exclusive).
+template <typename C>
+static int row_of_min_value_in_column(const BasicMatrix<C> *mat, int column,
+                                      int row_start, int row_end) {
+  int w = Matrix_width(mat);
+  const C *p = Matrix_row(mat, row_start).data + column;
+  C min_value = *p;
+  int min_row = row_start;
+  for (int i = row_start + 1; i < row_end; ++i) {
+    p += w;
+    if (*p < min_value) {
+      min_value = *p;
+      min_row = i;
+    }
+  }
+  return min_row;
+}
+
+// REQUIRES: cost points to a valid horizontal cost Matrix
+// EFFECTS:  Returns the horizontal seam with the minimal cost according to
+//           the given cost matrix, represented as a vector filled with the
+//           row numbers for each pixel along the seam, starting with the
+//           first column (left of image). The length of the returned vector
+//           is equal to Matrix_width(cost).
+//           The seam is found starting from the first column, and if any
+//           pixels tie for lowest cost, the topmost one (i.e. with the
+//           lowest row number) is used. This matches the seam that
+//           find_minimal_vertical_seam finds in the rotated image.
+template <typename C>
+vector<int> find_minimal_horizontal_seam(const BasicMatrix<C> *cost) {
+  vector<int> seam(Matrix_width(cost));
+  find_minimal_horizontal_seam(cost, seam.data());
   return seam;
 }
 
+// REQUIRES: cost points to a valid horizontal cost Matrix
+//           seam points to an array of Matrix_width(cost) ints
+// MODIFIES: seam[0], ..., seam[Matrix_width(cost) - 1]
+// EFFECTS:  Same as find_minimal_horizontal_seam(cost), but writes the
+//           seam into the given array instead of returning a new vector.
+template <typename C>
+void find_minimal_horizontal_seam(const BasicMatrix<C> *cost, int *seam) {
+  int h = Matrix_height(cost);
+  int w = Matrix_width(cost);
+  int row = row_of_min_value_in_column(cost, 0, 0, h);
+  seam[0] = row;
+
+  for (int j = 1; j < w; ++j) {
+    int start = max(row - 1, 0);
+    int end = min(row + 2, h);
+    row = row_of_min_value_in_column(cost, j, start, end);
+    seam[j] = row;
+  }
+}
+
 // REQUIRES: img points to a valid Image with width >= 2
 //           seam.size() == Image_height(img)
 //           each element x in seam satisfies 0 <= x < Image_width(img)
@@ -193,28 +1160,148 @@ vector<int> find_minimal_vertical_seam(const Matrix *cost) {
 //           removed from row r will be the one with column equal to seam[r].
 //           The width of the image will be one less than before.
 //           See the project spec for details on removing a vertical seam.
-// NOTE:     Declare a new variable to hold the smaller Image, and
-//           then do an assignment at the end to copy it back into the
-//           original image.
-void remove_vertical_seam(Image *img, const vector<int> &seam) {
-  int h = Image_height(img);
-  int w = Image_width(img);
-  Image resized;
-  Image_init(&resized, w - 1, h);
+// NOTE:     This is done in place by remove_vertical_seam_in_place.
+template <typename Img>
+void remove_vertical_seam(Img *img, const vector<int> &seam) {
+  remove_vertical_seam_in_place(img, seam);
+}
 
-  for (int i = 0; i < h; ++i) {
-    int skipCol = seam[i];
-    int newCol = 0;
-
-    for (int j = 0; j < w; ++j) {
-      if (j != skipCol) {
-        Pixel p = Image_get_pixel(img, i, j);
-        Image_set_pixel(&resized, i, newCol, p);
-        ++newCol;
-      }
-    }
+// REQUIRES: mat points to a valid Matrix with width >= 2
+//           seam.size() == Matrix_height(mat)
+// MODIFIES: *mat
+// EFFECTS:  Removes element seam[r] from each row r of the Matrix in place.
+template <typename T>
+static void remove_seam_from_matrix(BasicMatrix<T> *mat,
+                                    const vector<int> &seam) {
+  PixelRows<T> rows = { mat->data.data(), mat->width, 1 };
+  for (int i = 0; i < mat->height; ++i) {
+    shift_row_past_seam(rows, i, seam[i]);
+  }
+  --mat->width;
+  mat->data.resize((long long)mat->width * mat->height);
+}
+
+// EFFECTS:  Removes the seam from each of the three channels in place.
+static void remove_seam_from_pixels(Image *img, const vector<int> &seam) {
+  remove_seam_from_matrix(&img->red_channel, seam);
+  remove_seam_from_matrix(&img->green_channel, seam);
+  remove_seam_from_matrix(&img->blue_channel, seam);
+}
+
+// EFFECTS:  Removes the seam from the interleaved pixels in place.
+static void remove_seam_from_pixels(PackedImage *img,
+                                    const vector<int> &seam) {
+  PixelRows<uint8_t> rows = { img->data.data(), img->width, 3 };
+  for (int i = 0; i < img->height; ++i) {
+    shift_row_past_seam(rows, i, seam[i]);
+  }
+  img->data.resize(3 * (long long)(img->width - 1) * img->height);
+}
+
+// EFFECTS:  Removes the seam from the viewed pixels in place, moving the
+//           rest of each row left within the view. The last column of
+//           the view keeps its old pixels.
+static void remove_seam_from_pixels(ImageView *img,
+                                    const vector<int> &seam) {
+  for (int i = 0; i < img->height; ++i) {
+    uint8_t *row = img->data + i * img->stride;
+    int column = seam[i];
+    memmove(row + 3 * column, row + 3 * (column + 1),
+            3 * (img->width - column - 1));
+  }
+}
+
+// REQUIRES: img points to a valid Image with width >= 2
+//           seam.size() == Image_height(img)
+//           each element x in seam satisfies 0 <= x < Image_width(img)
+// MODIFIES: *img
+// EFFECTS:  Same as remove_vertical_seam(img, seam), but without building a
+//           second Image: each row is moved into place with at most two
+//           memmoves, dropping the seam pixel. The pixel storage keeps its
+//           capacity, so removing many seams never reallocates it.
+template <typename Img>
+void remove_vertical_seam_in_place(Img *img, const vector<int> &seam) {
+  remove_seam_from_pixels(img, seam);
+  --img->width;
+}
+
+// EFFECTS:  Removes the horizontal seam from each of the three channels.
+static void remove_horizontal_seam_from_pixels(Image *img,
+                                               const vector<int> &seam) {
+  Matrix8 *channels[] = { &img->red_channel, &img->green_channel,
+                          &img->blue_channel };
+  for (Matrix8 *channel : channels) {
+    PixelRows<uint8_t> rows = { channel->data.data(), img->width, 1 };
+    shift_rows_past_seam(rows, img->height, seam);
+    --channel->height;
+    channel->data.resize((long long)img->width * channel->height);
+  }
+}
+
+// EFFECTS:  Removes the horizontal seam from the interleaved pixels.
+static void remove_horizontal_seam_from_pixels(PackedImage *img,
+                                               const vector<int> &seam) {
+  PixelRows<uint8_t> rows = { img->data.data(), img->width, 3 };
+  shift_rows_past_seam(rows, img->height, seam);
+  img->data.resize(3 * (long long)img->width * (img->height - 1));
+}
+
+// REQUIRES: img points to a valid Image with height >= 2
+//           seam.size() == Image_width(img)
+//           each element x in seam satisfies 0 <= x < Image_height(img)
+// MODIFIES: *img
+// EFFECTS:  Removes the given horizontal seam from the Image in place. The
+//           pixel removed from column c will be the one with row equal to
+//           seam[c], and the pixels below it move up by one row.
+//           The height of the image will be one less than before.
+template <typename Img>
+void remove_horizontal_seam(Img *img, const vector<int> &seam) {
+  remove_horizontal_seam_from_pixels(img, seam);
+  --img->height;
+}
+
+// REQUIRES: carver points to a SeamCarver
+//           img points to a valid Image
+// MODIFIES: *carver
+// EFFECTS:  Initializes the workspace for carving the given Image.
+template <typename Img>
+void SeamCarver_init(SeamCarver *carver, const Img *img) {
+  IncrementalEnergy_init(&carver->energy, img);
+  compute_vertical_cost_matrix(&carver->energy.energy, &carver->cost);
+  carver->seam.assign(Image_height(img), 0);
+}
+
+template <typename Img>
+static void SeamCarver_update(SeamCarver *carver, const Img *img);
+
+// REQUIRES: img points to a valid Image with width >= 2
+//           carver points to a SeamCarver initialized for img, and img
+//           has only been changed by SeamCarver_remove_seam since
+// MODIFIES: *carver, *img
+// EFFECTS:  Removes the minimal vertical seam from the Image, exactly as
+//           one iteration of seam_carve_width does.
+template <typename Img>
+void SeamCarver_remove_seam(SeamCarver *carver, Img *img) {
+  find_minimal_vertical_seam(&carver->cost, carver->seam.data());
+  remove_vertical_seam_in_place(img, carver->seam);
+  SeamCarver_update(carver, img);
+}
+
+// REQUIRES: carver points to a SeamCarver that was initialized for img
+//           img has just had the vertical seam carver->seam removed
+// MODIFIES: *carver
+// EFFECTS:  Brings the energy and cost matrices up to date with img.
+template <typename Img>
+static void SeamCarver_update(SeamCarver *carver, const Img *img) {
+  int old_max = carver->energy.max_energy;
+  IncrementalEnergy_remove_vertical_seam(&carver->energy, img, carver->seam);
+  if (carver->energy.max_energy == old_max) {
+    update_vertical_cost_matrix(&carver->energy.energy, &carver->cost,
+                                carver->seam);
+  } else {
+    // The border changed, which affects every column.
+    compute_vertical_cost_matrix(&carver->energy.energy, &carver->cost);
   }
-  *img = resized;
 }
 
 // REQUIRES: img points to a valid Image
@@ -225,15 +1312,114 @@ void remove_vertical_seam(Image *img, const vector<int> &seam) {
 // NOTE:     Use a vector to hold the seam, and make sure that it has
 //           the right size. You can use .data() on a vector to get
 //           the underlying array.
-void seam_carve_width(Image *img, int newWidth) {
+template <typename Img>
+void seam_carve_width(Img *img, int newWidth) {
+  if (Image_width(img) == newWidth) {
+    return;
+  }
+  SeamCarver carver;
+  SeamCarver_init(&carver, img);
   while (Image_width(img) > newWidth) {
-    Matrix energy;
-    Matrix cost;
-    compute_energy_matrix(img, &energy);
-    compute_vertical_cost_matrix(&energy, &cost);
+    SeamCarver_remove_seam(&carver, img);
+  }
+}
 
-    vector<int> seam = find_minimal_vertical_seam(&cost);
-    remove_vertical_seam(img, seam);
+// REQUIRES: map points to a SeamIndexMap
+//           img points to a valid Image
+//           0 < minWidth && minWidth <= Image_width(img)
+// MODIFIES: *map
+// EFFECTS:  Carves a copy of the image down to minWidth and records in
+//           map the iteration at which each pixel was removed.
+template <typename Img>
+void SeamIndexMap_init(SeamIndexMap *map, const Img *img, int minWidth) {
+  int width = Image_width(img);
+  int height = Image_height(img);
+  map->min_width = minWidth;
+  Matrix_init(&map->removed_at, width, height);
+  Matrix_fill(&map->removed_at, REMOVED_NEVER);
+  if (width == minWidth) {
+    return;
+  }
+
+  // columns holds the original column of each remaining pixel and is
+  // narrowed alongside the image.
+  vector<int> columns((long long)width * height);
+  for (int i = 0; i < height; ++i) {
+    for (int j = 0; j < width; ++j) {
+      columns[(long long)i * width + j] = j;
+    }
+  }
+
+  Img work = *img;
+  SeamCarver carver;
+  SeamCarver_init(&carver, &work);
+  for (uint32_t k = 0; Image_width(&work) > minWidth; ++k) {
+    PixelRows<int> rows = { columns.data(), Image_width(&work), 1 };
+    SeamCarver_remove_seam(&carver, &work);
+    for (int i = 0; i < height; ++i) {
+      int j = carver.seam[i];
+      int original = columns[(long long)i * rows.width + j];
+      Matrix_row(&map->removed_at, i)[original] = k;
+      shift_row_past_seam(rows, i, j);
+    }
+  }
+}
+
+// REQUIRES: img and out have the same height
+//           0 <= row < Image_height(img)
+//           kept holds Image_width(out) columns of img in increasing order
+// MODIFIES: *out
+// EFFECTS:  Copies the pixels in the given columns of the given row of
+//           img, in order, into the same row of out.
+static void copy_kept_pixels(const Image *img, Image *out, int row,
+                             const vector<int> &kept) {
+  ChannelRows in = Image_row(img, row);
+  ImageRow<uint8_t> to = Image_row(out, row);
+  for (int c = 0; c < (int)kept.size(); ++c) {
+    to.red[c] = in.red[kept[c]];
+    to.green[c] = in.green[kept[c]];
+    to.blue[c] = in.blue[kept[c]];
+  }
+}
+
+// EFFECTS:  Same as copy_kept_pixels for an Image.
+static void copy_kept_pixels(const PackedImage *img, PackedImage *out,
+                             int row, const vector<int> &kept) {
+  const uint8_t *in = &img->data[3 * (long long)row * img->width];
+  uint8_t *to = &out->data[3 * (long long)row * out->width];
+  for (int column : kept) {
+    memcpy(to, in + 3 * column, 3);
+    to += 3;
+  }
+}
+
+// REQUIRES: map points to a SeamIndexMap initialized from img
+//           img and out point to distinct Images
+//           map->min_width <= newWidth && newWidth <= Image_width(img)
+// MODIFIES: *out
+// EFFECTS:  Initializes out to the image seam_carve_width(img, newWidth)
+//           would produce, in a single pass over img.
+// NOTE:     Carving to newWidth removes the first width - newWidth seams
+//           of the map, so a pixel is kept if it was removed at a later
+//           iteration or never.
+template <typename Img>
+void SeamIndexMap_retarget(const SeamIndexMap *map, const Img *img,
+                           Img *out, int newWidth) {
+  int width = Image_width(img);
+  int height = Image_height(img);
+  uint32_t removed = width - newWidth;
+  Image_init(out, newWidth, height);
+  vector<int> kept;
+  kept.reserve(newWidth);
+  for (int i = 0; i < height; ++i) {
+    RowSpan<const uint32_t> removed_at = Matrix_row(&map->removed_at, i);
+    kept.clear();
+    for (int j = 0; j < width; ++j) {
+      if (removed_at[j] >= removed) {
+        kept.push_back(j);
+      }
+    }
+    copy_kept_pixels(img, out, i, kept);
   }
 }
 
@@ -243,28 +1429,33 @@ void seam_carve_width(Image *img, int newWidth) {
 // EFFECTS:  Reduces the height of the given Image to be newHeight.
 // NOTE:     This is equivalent to first rotating the Image 90 degrees left,
 //           then applying seam_carve_width(img, newHeight), then rotating
-//           90 degrees right.
-void seam_carve_height(Image *img, int newHeight) {
-  Image rotated;
-  Image_init(&rotated, Image_height(img), Image_width(img));
-
-  for (int i = 0; i < Image_height(img); ++i) {
-    for (int j = 0; j < Image_width(img); ++j) {
-      Pixel p = Image_get_pixel(img, i, j);
-      Image_set_pixel(&rotated, Image_width(img) - 1 - j, i, p);
-    }
+//           90 degrees right, but the Image and its energy and cost
+//           matrices stay in row-major order: horizontal seams are found
+//           and removed directly, and the matrices are updated the same
+//           incremental way seam_carve_width updates them.
+template <typename Img>
+void seam_carve_height(Img *img, int newHeight) {
+  if (Image_height(img) == newHeight) {
+    return;
   }
-  seam_carve_width(&rotated, newHeight);
-  Image unrotated;
-  Image_init(&unrotated, Image_height(&rotated), Image_width(&rotated));
-
-  for (int i = 0; i < Image_height(&rotated); ++i) {
-    for (int j = 0; j < Image_width(&rotated); ++j) {
-      Pixel p = Image_get_pixel(&rotated, i, j);
-      Image_set_pixel(&unrotated, j, Image_height(&rotated) - 1 - i, p);
+  SeamCarver carver;
+  IncrementalEnergy_init(&carver.energy, img);
+  compute_horizontal_cost_matrix(&carver.energy.energy, &carver.cost);
+  carver.seam.assign(Image_width(img), 0);
+  while (Image_height(img) > newHeight) {
+    find_minimal_horizontal_seam(&carver.cost, carver.seam.data());
+    remove_horizontal_seam(img, carver.seam);
+    int old_max = carver.energy.max_energy;
+    IncrementalEnergy_remove_horizontal_seam(&carver.energy, img,
+                                             carver.seam);
+    if (carver.energy.max_energy == old_max) {
+      update_horizontal_cost_matrix(&carver.energy.energy, &carver.cost,
+                                    carver.seam);
+    } else {
+      // The border changed, which affects every row.
+      compute_horizontal_cost_matrix(&carver.energy.energy, &carver.cost);
     }
   }
-  *img = unrotated;
 }
 
 // REQUIRES: img points to a valid Image
@@ -275,7 +1466,97 @@ void seam_carve_height(Image *img, int newHeight) {
 //           and newHeight, respectively.
 // NOTE:     This is equivalent to applying seam_carve_width(img, newWidth)
 //           and then applying seam_carve_height(img, newHeight).
-void seam_carve(Image *img, int newWidth, int newHeight) {
+template <typename Img>
+void seam_carve(Img *img, int newWidth, int newHeight) {
   seam_carve_width(img, newWidth);
   seam_carve_height(img, newHeight);
 }
+
+// Explicit instantiations for the supported image and matrix types.
+template void compute_vertical_cost_matrix(const Matrix*, Matrix*);
+template void compute_vertical_cost_matrix(const Matrix16*, Matrix32*);
+template void compute_vertical_cost_matrix(const MatrixView<int>*,
+                                           MatrixView<int>*);
+template void compute_vertical_cost_matrix(const MatrixView<const int>*,
+                                           MatrixView<int>*);
+template void compute_vertical_cost_matrix(const MatrixView<uint16_t>*,
+                                           MatrixView<uint32_t>*);
+template void compute_vertical_cost_matrix(const MatrixView<const uint16_t>*,
+                                           MatrixView<uint32_t>*);
+template void update_vertical_cost_matrix(const Matrix*, Matrix*,
+                                          const vector<int>&);
+template void update_vertical_cost_matrix(const Matrix16*, Matrix32*,
+                                          const vector<int>&);
+template void compute_horizontal_cost_matrix(const Matrix*, Matrix*);
+template void compute_horizontal_cost_matrix(const Matrix16*, Matrix32*);
+template void update_horizontal_cost_matrix(const Matrix*, Matrix*,
+                                            const vector<int>&);
+template void update_horizontal_cost_matrix(const Matrix16*, Matrix32*,
+                                            const vector<int>&);
+template vector<int> find_minimal_vertical_seam(const Matrix*);
+template vector<int> find_minimal_vertical_seam(const Matrix32*);
+template void find_minimal_vertical_seam(const Matrix*, int*);
+template void find_minimal_vertical_seam(const Matrix32*, int*);
+template vector<int> find_minimal_horizontal_seam(const Matrix*);
+template vector<int> find_minimal_horizontal_seam(const Matrix32*);
+template void find_minimal_horizontal_seam(const Matrix*, int*);
+template void find_minimal_horizontal_seam(const Matrix32*, int*);
+template void compute_energy_matrix(const Image*, Matrix*);
+template void compute_energy_matrix(const Image*, Matrix16*);
+template void compute_energy_matrix(const PackedImage*, Matrix*);
+template void compute_energy_matrix(const PackedImage*, Matrix16*);
+template void compute_energy_matrix(const ImageView*, Matrix*);
+template void compute_energy_matrix(const ImageView*, Matrix16*);
+template void compute_energy_matrix(const Image*, MatrixView<int>*);
+template void compute_energy_matrix(const Image*, MatrixView<uint16_t>*);
+template void compute_energy_matrix(const PackedImage*, MatrixView<int>*);
+template void compute_energy_matrix(const PackedImage*,
+                                    MatrixView<uint16_t>*);
+template void compute_energy_matrix(const ImageView*, MatrixView<int>*);
+template void compute_energy_matrix(const ImageView*, MatrixView<uint16_t>*);
+template void IncrementalEnergy_init(IncrementalEnergy*, const Image*);
+template void IncrementalEnergy_init(IncrementalEnergy*, const PackedImage*);
+template void IncrementalEnergy_init(IncrementalEnergy*, const ImageView*);
+template void IncrementalEnergy_remove_vertical_seam(IncrementalEnergy*,
+                                                     const Image*,
+                                                     const vector<int>&);
+template void IncrementalEnergy_remove_vertical_seam(IncrementalEnergy*,
+                                                     const PackedImage*,
+                                                     const vector<int>&);
+template void IncrementalEnergy_remove_vertical_seam(IncrementalEnergy*,
+                                                     const ImageView*,
+                                                     const vector<int>&);
+template void IncrementalEnergy_remove_horizontal_seam(IncrementalEnergy*,
+                                                       const Image*,
+                                                       const vector<int>&);
+template void IncrementalEnergy_remove_horizontal_seam(IncrementalEnergy*,
+                                                       const PackedImage*,
+                                                       const vector<int>&);
+template void remove_vertical_seam(Image*, const vector<int>&);
+template void remove_vertical_seam(PackedImage*, const vector<int>&);
+template void remove_vertical_seam(ImageView*, const vector<int>&);
+template void remove_vertical_seam_in_place(Image*, const vector<int>&);
+template void remove_vertical_seam_in_place(PackedImage*,
+                                            const vector<int>&);
+template void remove_vertical_seam_in_place(ImageView*, const vector<int>&);
+template void remove_horizontal_seam(Image*, const vector<int>&);
+template void remove_horizontal_seam(PackedImage*, const vector<int>&);
+template void SeamCarver_init(SeamCarver*, const Image*);
+template void SeamCarver_init(SeamCarver*, const PackedImage*);
+template void SeamCarver_init(SeamCarver*, const ImageView*);
+template void SeamCarver_remove_seam(SeamCarver*, Image*);
+template void SeamCarver_remove_seam(SeamCarver*, PackedImage*);
+template void SeamCarver_remove_seam(SeamCarver*, ImageView*);
+template void SeamIndexMap_init(SeamIndexMap*, const Image*, int);
+template void SeamIndexMap_init(SeamIndexMap*, const PackedImage*, int);
+template void SeamIndexMap_retarget(const SeamIndexMap*, const Image*,
+                                    Image*, int);
+template void SeamIndexMap_retarget(const SeamIndexMap*,
+                                    const PackedImage*, PackedImage*, int);
+template void seam_carve_width(Image*, int);
+template void seam_carve_width(PackedImage*, int);
+template void seam_carve_width(ImageView*, int);
+template void seam_carve_height(Image*, int);
+template void seam_carve_height(PackedImage*, int);
+template void seam_carve(Image*, int, int);
+template void seam_carve(PackedImage*, int, int);
@@ -14,6 +14,11 @@ void rotate_left(Image* img);
 // EFFECTS:  The image is rotated 90 degrees to the right (clockwise).
 void rotate_right(Image* img);
 
+// The functions below that take an image are templates instantiated in
+// processing.cpp for both Image and PackedImage. Those that work on
+// vertical seams are also instantiated for ImageView, so an image held
+// in caller-owned memory can be carved in place.
+
 // REQUIRES: img points to a valid Image.
 //           energy points to a Matrix.
 // MODIFIES: *energy
@@ -22,7 +27,59 @@ void rotate_right(Image* img);
 //           size as the given Image, and then the energy matrix for that
 //           image is computed and written into it.
 //           See the project spec for details on computing the energy matrix.
-void compute_energy_matrix(const Image* img, Matrix* energy);
+//           Instantiated for Matrix and the compact Matrix16.
+template <typename Img, typename E>
+void compute_energy_matrix(const Img* img, BasicMatrix<E>* energy);
+
+// REQUIRES: img points to a valid Image
+//           energy points to a valid MatrixView of the same size
+// MODIFIES: the elements viewed by energy
+// EFFECTS:  Computes the energy matrix of the image into the view,
+//           exactly as compute_energy_matrix(img, matrix) does.
+//           Instantiated for MatrixView<int> and MatrixView<uint16_t>.
+template <typename Img, typename E>
+void compute_energy_matrix(const Img* img, MatrixView<E>* energy);
+
+// Energy matrix of an image that is kept up to date as vertical seams
+// are removed, instead of being recomputed for every seam. Removing a
+// seam only changes the energy of the pixels next to it, plus the
+// border, which holds the maximum interior energy. To find that maximum
+// without a full scan, histogram[e] counts the interior pixels with
+// energy e.
+struct IncrementalEnergy {
+  Matrix16 energy;
+  std::vector<int> histogram;
+  int max_energy;
+};
+
+// REQUIRES: ie points to an IncrementalEnergy
+//           img points to a valid Image
+// MODIFIES: *ie
+// EFFECTS:  Initializes ie->energy to the energy matrix of the image,
+//           exactly as compute_energy_matrix does.
+template <typename Img>
+void IncrementalEnergy_init(IncrementalEnergy* ie, const Img* img);
+
+// REQUIRES: ie points to a valid IncrementalEnergy for an image
+//           img points to that image after remove_vertical_seam(img, seam)
+// MODIFIES: *ie
+// EFFECTS:  Updates ie->energy to the energy matrix of the carved image,
+//           recomputing only the pixels next to the seam and the border.
+template <typename Img>
+void IncrementalEnergy_remove_vertical_seam(IncrementalEnergy* ie,
+                                            const Img* img,
+                                            const std::vector<int> &seam);
+
+// REQUIRES: ie points to a valid IncrementalEnergy for an image
+//           img points to that image after remove_horizontal_seam(img, seam)
+// MODIFIES: *ie
+// EFFECTS:  Updates ie->energy to the energy matrix of the carved image,
+//           recomputing only the pixels next to the seam and the border.
+//           Instantiated for Image and PackedImage.
+template <typename Img>
+void IncrementalEnergy_remove_horizontal_seam(IncrementalEnergy* ie,
+                                              const Img* img,
+                                              const std::vector<int> &seam);
 
 // REQUIRES: energy points to a valid Matrix.
 //           cost points to a Matrix.
@@ -33,7 +90,74 @@ void compute_energy_matrix(const Image* img, Matrix* energy);
 //           size as the given energy Matrix, and then the cost matrix is
 //           computed and written into it.
 //           See the project spec for details on computing the cost matrix.
-void compute_vertical_cost_matrix(const Matrix* energy, Matrix *cost);
+//           Instantiated for Matrix -> Matrix and Matrix16 -> Matrix32.
+template <typename E, typename C>
+void compute_vertical_cost_matrix(const BasicMatrix<E>* energy,
+                                  BasicMatrix<C> *cost);
+
+// REQUIRES: energy points to a valid MatrixView
+//           cost points to a valid MatrixView of the same size
+//           energy and cost don't view the same elements
+// MODIFIES: the elements viewed by cost
+// EFFECTS:  Computes the vertical cost matrix of energy into the view,
+//           exactly as compute_vertical_cost_matrix(energy, matrix) does.
+//           Instantiated for int -> int and uint16_t -> uint32_t, with
+//           the energy view read-only or not.
+template <typename E, typename C>
+void compute_vertical_cost_matrix(const MatrixView<E>* energy,
+                                  MatrixView<C>* cost);
+
+// REQUIRES: cost points to the vertical cost matrix of an energy matrix
+//           energy points to that energy matrix after the given vertical
+//           seam was removed, where only pixels next to the seam changed
+//           and the border value did not change (as is the case after
+//           IncrementalEnergy_remove_vertical_seam if max_energy is the
+//           same as before)
+// MODIFIES: *cost
+// EFFECTS:  Updates cost to the vertical cost matrix of energy, exactly as
+//           compute_vertical_cost_matrix would compute it. Each row is
+//           shifted left past the seam, and only entries near the seam or
+//           below an entry that changed in the row above are recomputed.
+//           Instantiated for Matrix -> Matrix and Matrix16 -> Matrix32.
+template <typename E, typename C>
+void update_vertical_cost_matrix(const BasicMatrix<E>* energy,
+                                 BasicMatrix<C> *cost,
+                                 const std::vector<int> &seam);
+
+// REQUIRES: energy points to a valid Matrix.
+//           cost points to a Matrix.
+//           energy and cost aren't pointing to the same Matrix
+// MODIFIES: *cost
+// EFFECTS:  cost serves as an "output parameter".
+//           The Matrix pointed to by cost is initialized to be the same
+//           size as the given energy Matrix, and then the horizontal cost
+//           matrix is computed and written into it. The last column is
+//           the energy, and each entry of the other columns is its energy
+//           plus the minimal cost among the (up to) three entries above,
+//           beside and below it in the column to its right. This is the
+//           vertical cost matrix of the image rotated 90 degrees left,
+//           stored unrotated.
+//           Instantiated for Matrix -> Matrix and Matrix16 -> Matrix32.
+template <typename E, typename C>
+void compute_horizontal_cost_matrix(const BasicMatrix<E>* energy,
+                                    BasicMatrix<C> *cost);
+
+// REQUIRES: cost points to the horizontal cost matrix of an energy matrix
+//           energy points to that energy matrix after the given horizontal
+//           seam was removed, where only pixels next to the seam changed
+//           and the border value did not change (as is the case after
+//           IncrementalEnergy_remove_horizontal_seam if max_energy is the
+//           same as before)
+// MODIFIES: *cost
+// EFFECTS:  Updates cost to the horizontal cost matrix of energy, exactly
+//           as compute_horizontal_cost_matrix would compute it, shifting
+//           the rows up past the seam and recomputing only entries near
+//           the seam or next to an entry that changed.
+//           Instantiated for Matrix -> Matrix and Matrix16 -> Matrix32.
+template <typename E, typename C>
+void update_horizontal_cost_matrix(const BasicMatrix<E>* energy,
+                                   BasicMatrix<C> *cost,
+                                   const std::vector<int> &seam);
 
 // REQUIRES: cost points to a valid Matrix
 // EFFECTS:  Returns the vertical seam with the minimal cost according to the given
@@ -44,7 +168,39 @@ void compute_vertical_cost_matrix(const Matrix* energy, Matrix *cost);
 //           While determining the seam, if any pixels tie for lowest cost, the
 //           leftmost one (i.e. with the lowest column number) is used.
 //           See the project spec for details on computing the minimal seam.
-std::vector<int> find_minimal_vertical_seam(const Matrix* cost);
+//           Instantiated for Matrix and Matrix32.
+template <typename C>
+std::vector<int> find_minimal_vertical_seam(const BasicMatrix<C>* cost);
+
+// REQUIRES: cost points to a valid Matrix
+//           seam points to an array of Matrix_height(cost) ints
+// MODIFIES: seam[0], ..., seam[Matrix_height(cost) - 1]
+// EFFECTS:  Same as find_minimal_vertical_seam(cost), but writes the seam
+//           into the given array instead of returning a new vector.
+template <typename C>
+void find_minimal_vertical_seam(const BasicMatrix<C>* cost, int* seam);
+
+// REQUIRES: cost points to a valid horizontal cost Matrix
+// EFFECTS:  Returns the horizontal seam with the minimal cost according to
+//           the given cost matrix, represented as a vector filled with the
+//           row numbers for each pixel along the seam, starting with the
+//           first column (left of image). The length of the returned vector
+//           is equal to Matrix_width(cost).
+//           The seam is found starting from the first column, and if any
+//           pixels tie for lowest cost, the topmost one (i.e. with the
+//           lowest row number) is used. This matches the seam that
+//           find_minimal_vertical_seam finds in the rotated image.
+//           Instantiated for Matrix and Matrix32.
+template <typename C>
+std::vector<int> find_minimal_horizontal_seam(const BasicMatrix<C>* cost);
+
+// REQUIRES: cost points to a valid horizontal cost Matrix
+//           seam points to an array of Matrix_width(cost) ints
+// MODIFIES: seam[0], ..., seam[Matrix_width(cost) - 1]
+// EFFECTS:  Same as find_minimal_horizontal_seam(cost), but writes the
+//           seam into the given array instead of returning a new vector.
+template <typename C>
+void find_minimal_horizontal_seam(const BasicMatrix<C>* cost, int* seam);
 
 // REQUIRES: img points to a valid Image with width >= 2
 //           seam.size() == Image_height(img)
@@ -55,10 +211,59 @@ std::vector<int> find_minimal_vertical_seam(const Matrix* cost);
 //           removed from row r will be the one with column equal to seam[r].
 //           The width of the image will be one less than before.
 //           See the project spec for details on removing a vertical seam.
-// NOTE:     Declare a new variable to hold the smaller Image, and
-//           then do an assignment at the end to copy it back into the
-//           original image.
-void remove_vertical_seam(Image *img, const std::vector<int> &seam);
+// NOTE:     This is done in place by remove_vertical_seam_in_place.
+//           For an ImageView, the rest of each row moves left within
+//           the view and the pixels in its last column are left as they
+//           were, since they belong to the caller's buffer.
+template <typename Img>
+void remove_vertical_seam(Img *img, const std::vector<int> &seam);
+
+// REQUIRES: img points to a valid Image with width >= 2
+//           seam.size() == Image_height(img)
+//           each element x in seam satisfies 0 <= x < Image_width(img)
+// MODIFIES: *img
+// EFFECTS:  Same as remove_vertical_seam(img, seam), but without building a
+//           second Image: each row is moved into place with at most two
+//           memmoves, dropping the seam pixel. The pixel storage keeps its
+//           capacity, so removing many seams never reallocates it.
+template <typename Img>
+void remove_vertical_seam_in_place(Img *img, const std::vector<int> &seam);
+
+// Workspace for removing many vertical seams from one image. It owns the
+// energy, cost and seam buffers, which are sized for the original image
+// and reused for every seam, so carving does not allocate per seam.
+struct SeamCarver {
+  IncrementalEnergy energy;
+  Matrix32 cost;
+  std::vector<int> seam;
+};
+
+// REQUIRES: carver points to a SeamCarver
+//           img points to a valid Image
+// MODIFIES: *carver
+// EFFECTS:  Initializes the workspace for carving the given Image.
+template <typename Img>
+void SeamCarver_init(SeamCarver* carver, const Img* img);
+
+// REQUIRES: img points to a valid Image with width >= 2
+//           carver points to a SeamCarver initialized for img, and img
+//           has only been changed by SeamCarver_remove_seam since
+// MODIFIES: *carver, *img
+// EFFECTS:  Removes the minimal vertical seam from the Image, exactly as
+//           one iteration of seam_carve_width does.
+template <typename Img>
+void SeamCarver_remove_seam(SeamCarver* carver, Img* img);
+
+// REQUIRES: img points to a valid Image with height >= 2
+//           seam.size() == Image_width(img)
+//           each element x in seam satisfies 0 <= x < Image_height(img)
+// MODIFIES: *img
+// EFFECTS:  Removes the given horizontal seam from the Image in place. The
+//           pixel removed from column c will be the one with row equal to
+//           seam[c], and the pixels below it move up by one row.
+//           The height of the image will be one less than before.
+template <typename Img>
+void remove_horizontal_seam(Img *img, const std::vector<int> &seam);
 
 // REQUIRES: img points to a valid Image
 //           0 < newWidth && newWidth <= Image_width(img)
@@ -68,7 +273,8 @@ void remove_vertical_seam(Image *img, const std::vector<int> &seam);
 // NOTE:     Use a vector to hold the seam, and make sure that it has
 //           the right size. You can use .data() on a vector to get
 //           the underlying array.
-void seam_carve_width(Image *img, int newWidth);
+template <typename Img>
+void seam_carve_width(Img *img, int newWidth);
 
 // REQUIRES: img points to a valid Image
 //           0 < newHeight && newHeight <= Image_height(img)
@@ -76,8 +282,11 @@ void seam_carve_width(Image *img, int newWidth);
 // EFFECTS:  Reduces the height of the given Image to be newHeight.
 // NOTE:     This is equivalent to first rotating the Image 90 degrees left,
 //           then applying seam_carve_width(img, newHeight), then rotating
-//           90 degrees right.
-void seam_carve_height(Image *img, int newHeight);
+//           90 degrees right, but horizontal seams are found and removed
+//           directly: neither the Image nor its energy and cost matrices
+//           are ever rotated.
+template <typename Img>
+void seam_carve_height(Img *img, int newHeight);
 
 // REQUIRES: img points to a valid Image
 //           0 < newWidth && newWidth <= Image_width(img)
@@ -87,7 +296,41 @@ void seam_carve_height(Image *img, int newHeight);
 //           and newHeight, respectively.
 // NOTE:     This is equivalent to applying seam_carve_width(img, newWidth)
 //           and then applying seam_carve_height(img, newHeight).
-void seam_carve(Image *img, int newWidth, int newHeight);
+template <typename Img>
+void seam_carve(Img *img, int newWidth, int newHeight);
+
+// The order in which seam_carve_width removes the pixels of an image,
+// down to some minimum width. Carving to any width only removes a
+// prefix of that sequence of seams, so one precomputed map can produce
+// the image at every width in between without carving again.
+// removed_at holds, for each pixel of the original image, the iteration
+// at which its seam was removed, or REMOVED_NEVER if it survives to
+// min_width.
+struct SeamIndexMap {
+  int min_width;
+  Matrix32 removed_at;
+};
+
+const uint32_t REMOVED_NEVER = UINT32_MAX;
+
+// REQUIRES: map points to a SeamIndexMap
+//           img points to a valid Image
+//           0 < minWidth && minWidth <= Image_width(img)
+// MODIFIES: *map
+// EFFECTS:  Carves a copy of the image down to minWidth and records in
+//           map the iteration at which each pixel was removed.
+template <typename Img>
+void SeamIndexMap_init(SeamIndexMap *map, const Img *img, int minWidth);
+
+// REQUIRES: map points to a SeamIndexMap initialized from img
+//           img and out point to distinct Images
+//           map->min_width <= newWidth && newWidth <= Image_width(img)
+// MODIFIES: *out
+// EFFECTS:  Initializes out to the image seam_carve_width(img, newWidth)
+//           would produce, in a single pass over img.
+template <typename Img>
+void SeamIndexMap_retarget(const SeamIndexMap *map, const Img *img,
+                           Img *out, int newWidth);
 
 
 #endif // PROCESSING_HPP
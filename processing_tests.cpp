@@ -0,0 +1,911 @@
+#include "Matrix.hpp"
+#include "Image.hpp"
+#include "processing.hpp"
+#include "seam_index.hpp"
+#include "simd.hpp"
+#include "Matrix_test_helpers.hpp"
+#include "Image_test_helpers.hpp"
+#include "unit_test_framework.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+// Unit tests for the optimized paths in processing.cpp. Each one checks
+// a fast path against a straightforward computation of the same result.
+
+// REQUIRES: img points to an Image
+// MODIFIES: *img, *seed
+// EFFECTS:  Initializes img to the given size with pseudo-random pixels.
+static void random_image(Image *img, int width, int height, unsigned *seed) {
+  Image_init(img, width, height);
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      int values[3];
+      for (int &value : values) {
+        *seed = *seed * 1103515245 + 12345;
+        value = (*seed >> 16) % 256;
+      }
+      Image_set_pixel(img, r, c, { values[0], values[1], values[2] });
+    }
+  }
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: *img
+// EFFECTS:  Rounds every channel value of the image to 0 or 255.
+static void round_to_extremes(Image *img) {
+  for (int r = 0; r < Image_height(img); ++r) {
+    for (int c = 0; c < Image_width(img); ++c) {
+      Pixel p = Image_get_pixel(img, r, c);
+      Pixel rounded = { p.r < 128 ? 0 : 255, p.g < 128 ? 0 : 255,
+                        p.b < 128 ? 0 : 255 };
+      Image_set_pixel(img, r, c, rounded);
+    }
+  }
+}
+
+// REQUIRES: width > 0 && height > 0
+// MODIFIES: *seed
+// EFFECTS:  Returns a pseudo-random vertical seam through an image of the
+//           given size, moving at most one column between rows.
+static vector<int> random_seam(int width, int height, unsigned *seed) {
+  vector<int> seam(height);
+  *seed = *seed * 1103515245 + 12345;
+  seam[0] = (*seed >> 16) % width;
+  for (int r = 1; r < height; ++r) {
+    *seed = *seed * 1103515245 + 12345;
+    int step = (int)((*seed >> 16) % 3) - 1;
+    seam[r] = min(max(seam[r - 1] + step, 0), width - 1);
+  }
+  return seam;
+}
+
+// EFFECTS:  Returns whether mat1 and mat2 have the same size and the
+//           same elements, whatever their element types.
+template <typename A, typename B>
+static bool same_elements(const BasicMatrix<A> *mat1,
+                          const BasicMatrix<B> *mat2) {
+  if (Matrix_width(mat1) != Matrix_width(mat2) ||
+      Matrix_height(mat1) != Matrix_height(mat2)) {
+    return false;
+  }
+  for (int r = 0; r < Matrix_height(mat1); ++r) {
+    for (int c = 0; c < Matrix_width(mat1); ++c) {
+      if ((long long)*Matrix_at(mat1, r, c) !=
+          (long long)*Matrix_at(mat2, r, c)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// EFFECTS:  Returns the squared difference of p1 and p2 divided by 100,
+//           as the project spec defines it.
+static int spec_squared_difference(Pixel p1, Pixel p2) {
+  int dr = p2.r - p1.r;
+  int dg = p2.g - p1.g;
+  int db = p2.b - p1.b;
+  return (dr * dr + dg * dg + db * db) / 100;
+}
+
+// REQUIRES: img points to a valid Image
+//           energy points to a Matrix
+// MODIFIES: *energy
+// EFFECTS:  Computes the energy matrix of img pixel by pixel, as the
+//           project spec describes it.
+static void spec_energy_matrix(const Image *img, Matrix *energy) {
+  int w = Image_width(img);
+  int h = Image_height(img);
+  Matrix_init(energy, w, h);
+  for (int r = 1; r < h - 1; ++r) {
+    for (int c = 1; c < w - 1; ++c) {
+      *Matrix_at(energy, r, c) =
+        spec_squared_difference(Image_get_pixel(img, r, c - 1),
+                                Image_get_pixel(img, r, c + 1)) +
+        spec_squared_difference(Image_get_pixel(img, r - 1, c),
+                                Image_get_pixel(img, r + 1, c));
+    }
+  }
+  Matrix_fill_border(energy, Matrix_max(energy));
+}
+
+// Compares compute_energy_matrix on an Image, which uses the AVX2 kernel
+// when the CPU has it, against the spec's formula and the scalar kernel
+// used for PackedImage. The widths cover every remainder modulo the
+// 8-pixel vector width, and images of only 0 and 255 reach the largest
+// squared differences, where dividing by 100 with a multiply and shift
+// is most likely to be off by one.
+TEST(test_energy_matches_scalar)
+{
+  unsigned seed = 280;
+  for (int width = 1; width <= 27; ++width) {
+    for (int extremes = 0; extremes < 2; ++extremes) {
+      Image img;
+      random_image(&img, width, 5, &seed);
+      if (extremes) {
+        round_to_extremes(&img);
+      }
+      Matrix expected;
+      spec_energy_matrix(&img, &expected);
+
+      Matrix energy;
+      compute_energy_matrix(&img, &energy);
+      ASSERT_TRUE(Matrix_equal(&energy, &expected));
+      Matrix16 compact;
+      compute_energy_matrix(&img, &compact);
+      ASSERT_TRUE(same_elements(&compact, &expected));
+
+      PackedImage packed;
+      Image_init(&packed, &img);
+      compute_energy_matrix(&packed, &energy);
+      ASSERT_TRUE(Matrix_equal(&energy, &expected));
+    }
+  }
+}
+
+// REQUIRES: energy points to a valid Matrix
+// EFFECTS:  Returns the vertical cost matrix of energy in row-major
+//           order, computed entry by entry as the spec describes with
+//           64-bit sums.
+template <typename E>
+static vector<long long> spec_vertical_cost(const BasicMatrix<E> *energy) {
+  int w = Matrix_width(energy);
+  int h = Matrix_height(energy);
+  vector<long long> cost(energy->data.begin(), energy->data.end());
+  for (int r = 1; r < h; ++r) {
+    for (int c = 0; c < w; ++c) {
+      long long best = cost[(r - 1) * w + c];
+      for (int d = max(c - 1, 0); d <= min(c + 1, w - 1); ++d) {
+        best = min(best, cost[(r - 1) * w + d]);
+      }
+      cost[r * w + c] += best;
+    }
+  }
+  return cost;
+}
+
+// REQUIRES: energy points to a valid Matrix, 0 <= high, high fits in E
+// MODIFIES: *energy, *seed
+// EFFECTS:  Fills energy with pseudo-random values in [0, high].
+template <typename E>
+static void random_energy(BasicMatrix<E> *energy, int high, unsigned *seed) {
+  for (E &value : energy->data) {
+    *seed = *seed * 1103515245 + 12345;
+    value = (*seed >> 8) % (high + 1);
+  }
+}
+
+// REQUIRES: energy points to a valid Matrix
+// EFFECTS:  Checks that compute_vertical_cost_matrix matches the spec
+//           with each of the AVX2, SSE4.1 and scalar cost row kernels
+//           the CPU supports.
+template <typename E, typename C>
+static void check_cost_kernels(const BasicMatrix<E> *energy) {
+  vector<long long> expected = spec_vertical_cost(energy);
+  for (SimdLevel level : { SIMD_AVX2, SIMD_SSE41, SIMD_NONE }) {
+    simd_level_limit() = level;
+    BasicMatrix<C> cost;
+    compute_vertical_cost_matrix(energy, &cost);
+    ASSERT_TRUE(equal(cost.data.begin(), cost.data.end(), expected.begin()));
+  }
+  simd_level_limit() = SIMD_AVX2;
+}
+
+// Compares the vertical cost matrix computed with every cost row kernel
+// against the spec's formula, at widths covering every remainder modulo
+// both vector widths. In the tall 16-bit energy matrices the costs of
+// each row spread across 2^31 for a while, where comparing them as
+// signed integers would pick the wrong minimum.
+TEST(test_cost_kernels_match_scalar)
+{
+  unsigned seed = 4;
+  for (int width = 1; width <= 33; ++width) {
+    Matrix energy;
+    Matrix_init(&energy, width, 6);
+    random_energy(&energy, 1 << 20, &seed);
+    check_cost_kernels<int, int>(&energy);
+    Matrix16 compact;
+    Matrix_init(&compact, width, 6);
+    random_energy(&compact, 65535, &seed);
+    check_cost_kernels<uint16_t, uint32_t>(&compact);
+  }
+
+  for (int width : { 24, 29, 33 }) {
+    Matrix16 tall;
+    Matrix_init(&tall, width, 36000);
+    for (int r = 0; r < 36000; ++r) {
+      for (int c = 0; c < width; ++c) {
+        *Matrix_at(&tall, r, c) = c < width / 2 ? 65535 : 60000;
+      }
+    }
+    check_cost_kernels<uint16_t, uint32_t>(&tall);
+  }
+}
+
+// REQUIRES: img points to a valid Image with width > 2
+// MODIFIES: *img, *seed
+// EFFECTS:  Removes seams from the image down to width 2, alternating
+//           minimal and random seams, and checks after each one that the
+//           incrementally updated energy matrix and maximum match a full
+//           recompute.
+template <typename Img>
+static void check_incremental_energy(Img *img, unsigned *seed) {
+  IncrementalEnergy ie;
+  IncrementalEnergy_init(&ie, img);
+  for (int k = 0; Image_width(img) > 2; ++k) {
+    vector<int> seam;
+    if (k % 2 == 0) {
+      Matrix32 cost;
+      compute_vertical_cost_matrix(&ie.energy, &cost);
+      seam = find_minimal_vertical_seam(&cost);
+    } else {
+      seam = random_seam(Image_width(img), Image_height(img), seed);
+    }
+    remove_vertical_seam(img, seam);
+    IncrementalEnergy_remove_vertical_seam(&ie, img, seam);
+
+    Matrix16 expected;
+    compute_energy_matrix(img, &expected);
+    ASSERT_TRUE(same_elements(&ie.energy, &expected));
+    ASSERT_EQUAL(ie.max_energy, (int)*Matrix_at(&expected, 0, 0));
+  }
+}
+
+// Removes sequences of seams from random images, including images only
+// a few rows tall, and compares IncrementalEnergy with a full
+// compute_energy_matrix after every seam
+TEST(test_incremental_energy_matches_full)
+{
+  unsigned seed = 6;
+  int sizes[][2] = { { 3, 3 }, { 12, 3 }, { 17, 4 }, { 25, 19 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    PackedImage packed;
+    Image_init(&packed, &img);
+    check_incremental_energy(&img, &seed);
+    check_incremental_energy(&packed, &seed);
+  }
+}
+
+// REQUIRES: energy points to a valid Matrix with width >= 2
+//           seam is a vertical seam of energy
+// MODIFIES: *energy, *seed
+// EFFECTS:  Removes the seam from energy and gives new pseudo-random
+//           values to the interior entries next to it, the only ones
+//           whose energy can change when a seam is removed from an
+//           image. The border keeps its value.
+static void remove_seam_from_energy(Matrix *energy, const vector<int> &seam,
+                                    unsigned *seed) {
+  int w = Matrix_width(energy) - 1;
+  int h = Matrix_height(energy);
+  Matrix narrower;
+  Matrix_init(&narrower, w, h);
+  for (int r = 0; r < h; ++r) {
+    for (int c = 0; c < w; ++c) {
+      int from = c < seam[r] ? c : c + 1;
+      *Matrix_at(&narrower, r, c) = *Matrix_at(energy, r, from);
+    }
+  }
+  for (int r = 1; r < h - 1; ++r) {
+    int lo = min(min(seam[r - 1], seam[r]), seam[r + 1]) - 1;
+    int hi = max(max(seam[r - 1], seam[r]), seam[r + 1]);
+    for (int c = max(lo, 1); c <= min(hi, w - 2); ++c) {
+      *seed = *seed * 1103515245 + 12345;
+      *Matrix_at(&narrower, r, c) = (*seed >> 16) % 1000;
+    }
+  }
+  *energy = narrower;
+}
+
+// Removes random seams from random energy matrices one at a time and
+// compares update_vertical_cost_matrix with a full
+// compute_vertical_cost_matrix after each one. Random seams reach the
+// first and last columns, where the cone of changed entries is cut off
+// by the border.
+TEST(test_update_cost_matches_full)
+{
+  unsigned seed = 7;
+  int sizes[][2] = { { 3, 2 }, { 9, 3 }, { 16, 12 }, { 40, 30 } };
+  for (auto &size : sizes) {
+    Matrix energy;
+    Matrix_init(&energy, size[0], size[1]);
+    for (int r = 0; r < size[1]; ++r) {
+      for (int c = 0; c < size[0]; ++c) {
+        seed = seed * 1103515245 + 12345;
+        *Matrix_at(&energy, r, c) = (seed >> 16) % 1000;
+      }
+    }
+    Matrix_fill_border(&energy, 1000);
+    Matrix cost;
+    compute_vertical_cost_matrix(&energy, &cost);
+
+    while (Matrix_width(&energy) > 1) {
+      vector<int> seam =
+        random_seam(Matrix_width(&energy), Matrix_height(&energy), &seed);
+      remove_seam_from_energy(&energy, seam, &seed);
+      update_vertical_cost_matrix(&energy, &cost, seam);
+
+      Matrix expected;
+      compute_vertical_cost_matrix(&energy, &expected);
+      ASSERT_TRUE(Matrix_equal(&cost, &expected));
+    }
+  }
+}
+
+// Carves random images with the compact energy and cost types the way
+// SeamCarver does, updating the cost matrix whenever the border value
+// is unchanged, and compares it with a full recompute after every seam
+TEST(test_update_cost_matches_full_compact)
+{
+  unsigned seed = 8;
+  Image img;
+  random_image(&img, 30, 20, &seed);
+  IncrementalEnergy ie;
+  IncrementalEnergy_init(&ie, &img);
+  Matrix32 cost;
+  compute_vertical_cost_matrix(&ie.energy, &cost);
+  int updates = 0;
+  while (Image_width(&img) > 2) {
+    vector<int> seam = find_minimal_vertical_seam(&cost);
+    remove_vertical_seam(&img, seam);
+    int old_max = ie.max_energy;
+    IncrementalEnergy_remove_vertical_seam(&ie, &img, seam);
+    if (ie.max_energy == old_max) {
+      update_vertical_cost_matrix(&ie.energy, &cost, seam);
+      ++updates;
+    } else {
+      compute_vertical_cost_matrix(&ie.energy, &cost);
+    }
+
+    Matrix32 expected;
+    compute_vertical_cost_matrix(&ie.energy, &expected);
+    ASSERT_TRUE(same_elements(&cost, &expected));
+  }
+  ASSERT_TRUE(updates > 0);
+}
+
+// REQUIRES: img points to a valid Image
+//           0 < new_height && new_height <= Image_height(img)
+// EFFECTS:  Checks that seam_carve_height on the image, as an Image and
+//           as a PackedImage, matches rotating it left, carving its width
+//           and rotating it back.
+static void check_carve_height_matches_rotation(const Image *img,
+                                                int new_height) {
+  Image expected = *img;
+  rotate_left(&expected);
+  seam_carve_width(&expected, new_height);
+  rotate_right(&expected);
+
+  Image carved = *img;
+  seam_carve_height(&carved, new_height);
+  ASSERT_TRUE(Image_equal(&carved, &expected));
+
+  PackedImage packed;
+  Image_init(&packed, img);
+  seam_carve_height(&packed, new_height);
+  Image unpacked;
+  Image_init(&unpacked, &packed);
+  ASSERT_TRUE(Image_equal(&unpacked, &expected));
+}
+
+// Compares seam_carve_height with the rotation-based definition on
+// random images, on images of only 0 and 255, whose energies tie often,
+// and on a constant image, where every seam ties
+TEST(test_seam_carve_height_matches_rotation)
+{
+  unsigned seed = 10;
+  int sizes[][2] = { { 1, 5 }, { 3, 3 }, { 7, 16 }, { 33, 20 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    for (int height = 1; height <= size[1]; height += 3) {
+      check_carve_height_matches_rotation(&img, height);
+    }
+    round_to_extremes(&img);
+    check_carve_height_matches_rotation(&img, 2);
+    Image_fill(&img, { 9, 8, 7 });
+    check_carve_height_matches_rotation(&img, 1);
+  }
+}
+
+// Removes random horizontal seams and compares remove_horizontal_seam
+// with rotating left, removing the matching vertical seam and rotating
+// back
+TEST(test_remove_horizontal_seam_matches_rotation)
+{
+  unsigned seed = 11;
+  Image img;
+  random_image(&img, 21, 13, &seed);
+  while (Image_height(&img) > 1) {
+    int w = Image_width(&img);
+    vector<int> seam = random_seam(Image_height(&img), w, &seed);
+    Image expected = img;
+    rotate_left(&expected);
+    vector<int> rotated_seam(seam.rbegin(), seam.rend());
+    remove_vertical_seam(&expected, rotated_seam);
+    rotate_right(&expected);
+
+    PackedImage packed;
+    Image_init(&packed, &img);
+    remove_horizontal_seam(&img, seam);
+    ASSERT_TRUE(Image_equal(&img, &expected));
+    remove_horizontal_seam(&packed, seam);
+    Image unpacked;
+    Image_init(&unpacked, &packed);
+    ASSERT_TRUE(Image_equal(&unpacked, &expected));
+  }
+}
+
+// REQUIRES: img points to a valid Image
+// EFFECTS:  Checks that the horizontal cost matrix of the image is the
+//           vertical cost matrix of the image rotated left, turned back,
+//           and that the minimal horizontal seam is the minimal vertical
+//           seam of the rotated image, with energy type E and cost type C.
+template <typename E, typename C>
+static void check_horizontal_cost_matches_rotation(const Image *img) {
+  int w = Image_width(img);
+  int h = Image_height(img);
+  BasicMatrix<E> energy;
+  compute_energy_matrix(img, &energy);
+  BasicMatrix<C> cost;
+  compute_horizontal_cost_matrix(&energy, &cost);
+
+  Image rotated = *img;
+  rotate_left(&rotated);
+  BasicMatrix<E> rotated_energy;
+  compute_energy_matrix(&rotated, &rotated_energy);
+  BasicMatrix<C> rotated_cost;
+  compute_vertical_cost_matrix(&rotated_energy, &rotated_cost);
+
+  ASSERT_EQUAL(Matrix_width(&cost), w);
+  ASSERT_EQUAL(Matrix_height(&cost), h);
+  for (int r = 0; r < h; ++r) {
+    for (int c = 0; c < w; ++c) {
+      ASSERT_EQUAL(*Matrix_at(&cost, r, c),
+                   *Matrix_at(&rotated_cost, w - 1 - c, r));
+    }
+  }
+  vector<int> seam = find_minimal_horizontal_seam(&cost);
+  vector<int> rotated_seam = find_minimal_vertical_seam(&rotated_cost);
+  ASSERT_TRUE(equal(seam.begin(), seam.end(), rotated_seam.rbegin()));
+}
+
+// Compares compute_horizontal_cost_matrix and
+// find_minimal_horizontal_seam with the vertical functions on the
+// rotated image, on random images, on images of only 0 and 255 and on a
+// constant image, where the topmost of tied seams must be chosen
+TEST(test_horizontal_cost_matches_rotation)
+{
+  unsigned seed = 12;
+  int sizes[][2] = { { 1, 4 }, { 5, 1 }, { 3, 3 }, { 16, 7 }, { 20, 33 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    check_horizontal_cost_matches_rotation<int, int>(&img);
+    check_horizontal_cost_matches_rotation<uint16_t, uint32_t>(&img);
+    round_to_extremes(&img);
+    check_horizontal_cost_matches_rotation<uint16_t, uint32_t>(&img);
+    Image_fill(&img, { 9, 8, 7 });
+    check_horizontal_cost_matches_rotation<int, int>(&img);
+  }
+}
+
+// REQUIRES: img points to a valid Image with height > 2
+// MODIFIES: *img, *seed
+// EFFECTS:  Removes horizontal seams from the image down to height 2,
+//           alternating minimal and random seams, and checks after each
+//           one that the incrementally updated energy matrix, maximum and
+//           horizontal cost matrix match a full recompute.
+template <typename Img>
+static void check_incremental_horizontal(Img *img, unsigned *seed) {
+  IncrementalEnergy ie;
+  IncrementalEnergy_init(&ie, img);
+  Matrix32 cost;
+  compute_horizontal_cost_matrix(&ie.energy, &cost);
+  for (int k = 0; Image_height(img) > 2; ++k) {
+    int w = Image_width(img);
+    vector<int> seam = k % 2 == 0 ? find_minimal_horizontal_seam(&cost)
+                                  : random_seam(Image_height(img), w, seed);
+    remove_horizontal_seam(img, seam);
+    int old_max = ie.max_energy;
+    IncrementalEnergy_remove_horizontal_seam(&ie, img, seam);
+    if (ie.max_energy == old_max) {
+      update_horizontal_cost_matrix(&ie.energy, &cost, seam);
+    } else {
+      compute_horizontal_cost_matrix(&ie.energy, &cost);
+    }
+
+    Matrix16 expected;
+    compute_energy_matrix(img, &expected);
+    ASSERT_TRUE(same_elements(&ie.energy, &expected));
+    ASSERT_EQUAL(ie.max_energy, (int)*Matrix_at(&expected, 0, 0));
+    Matrix32 expected_cost;
+    compute_horizontal_cost_matrix(&expected, &expected_cost);
+    ASSERT_TRUE(same_elements(&cost, &expected_cost));
+  }
+}
+
+// Removes sequences of horizontal seams from random images, including
+// images only a few columns wide, and compares the incremental energy
+// and cost updates with a full recompute after every seam
+TEST(test_incremental_horizontal_matches_full)
+{
+  unsigned seed = 13;
+  int sizes[][2] = { { 3, 3 }, { 3, 12 }, { 4, 17 }, { 19, 25 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    PackedImage packed;
+    Image_init(&packed, &img);
+    check_incremental_horizontal(&img, &seed);
+    check_incremental_horizontal(&packed, &seed);
+  }
+}
+
+// REQUIRES: in points to a valid Matrix
+// MODIFIES: *out
+// EFFECTS:  Sets out to in rotated 90 degrees left, element by element.
+static void rotate_matrix_left(const Matrix *in, Matrix *out) {
+  int w = Matrix_width(in);
+  int h = Matrix_height(in);
+  Matrix_init(out, h, w);
+  for (int r = 0; r < w; ++r) {
+    for (int c = 0; c < h; ++c) {
+      *Matrix_at(out, r, c) = *Matrix_at(in, c, w - 1 - r);
+    }
+  }
+}
+
+// REQUIRES: in points to a valid Matrix
+// MODIFIES: *out
+// EFFECTS:  Sets out to in rotated 90 degrees right, element by element.
+static void rotate_matrix_right(const Matrix *in, Matrix *out) {
+  int w = Matrix_height(in);
+  int h = Matrix_width(in);
+  Matrix_init(out, w, h);
+  for (int r = 0; r < h; ++r) {
+    for (int c = 0; c < w; ++c) {
+      *Matrix_at(out, r, c) = *Matrix_at(in, w - 1 - c, r);
+    }
+  }
+}
+
+// Removes random horizontal seams from random energy matrices one at a
+// time and compares update_horizontal_cost_matrix with a full
+// compute_horizontal_cost_matrix after each one. The energy is updated
+// like the vertical case's, on the matrix rotated left.
+TEST(test_update_horizontal_cost_matches_full)
+{
+  unsigned seed = 14;
+  int sizes[][2] = { { 2, 3 }, { 3, 9 }, { 12, 16 }, { 30, 40 } };
+  for (auto &size : sizes) {
+    Matrix energy;
+    Matrix_init(&energy, size[0], size[1]);
+    for (int r = 0; r < size[1]; ++r) {
+      for (int c = 0; c < size[0]; ++c) {
+        seed = seed * 1103515245 + 12345;
+        *Matrix_at(&energy, r, c) = (seed >> 16) % 1000;
+      }
+    }
+    Matrix_fill_border(&energy, 1000);
+    Matrix cost;
+    compute_horizontal_cost_matrix(&energy, &cost);
+
+    while (Matrix_height(&energy) > 1) {
+      int w = Matrix_width(&energy);
+      int h = Matrix_height(&energy);
+      vector<int> seam = random_seam(h, w, &seed);
+      Matrix rotated;
+      rotate_matrix_left(&energy, &rotated);
+      vector<int> rotated_seam(seam.rbegin(), seam.rend());
+      remove_seam_from_energy(&rotated, rotated_seam, &seed);
+      rotate_matrix_right(&rotated, &energy);
+      update_horizontal_cost_matrix(&energy, &cost, seam);
+
+      Matrix expected;
+      compute_horizontal_cost_matrix(&energy, &expected);
+      ASSERT_TRUE(Matrix_equal(&cost, &expected));
+    }
+  }
+}
+
+// REQUIRES: img points to a valid Image
+//           rotated points to an Image
+// MODIFIES: *rotated
+// EFFECTS:  Sets rotated to the image rotated 90 degrees left, one pixel
+//           at a time.
+static void rotate_left_by_pixel(const Image *img, Image *rotated) {
+  int w = Image_width(img);
+  int h = Image_height(img);
+  Image_init(rotated, h, w);
+  for (int r = 0; r < w; ++r) {
+    for (int c = 0; c < h; ++c) {
+      Image_set_pixel(rotated, r, c, Image_get_pixel(img, c, w - 1 - r));
+    }
+  }
+}
+
+// Compares the tiled and vectorized rotations with rotating one pixel at
+// a time, on sizes that are and are not multiples of the 16-pixel block
+// and 64-pixel tile, so the vector kernel and the scalar strips around
+// it are both covered
+TEST(test_rotate_matches_per_pixel)
+{
+  unsigned seed = 11;
+  int sizes[][2] = { { 1, 1 }, { 1, 40 }, { 15, 17 }, { 16, 16 },
+                     { 33, 64 }, { 64, 128 }, { 130, 77 }, { 200, 31 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    Image expected;
+    rotate_left_by_pixel(&img, &expected);
+
+    Image rotated = img;
+    rotate_left(&rotated);
+    ASSERT_TRUE(Image_equal(&rotated, &expected));
+    rotate_right(&rotated);
+    ASSERT_TRUE(Image_equal(&rotated, &img));
+  }
+}
+
+// REQUIRES: img points to a valid Image
+//           0 < min_width && min_width <= Image_width(img)
+// EFFECTS:  Checks that retargeting img with one SeamIndexMap to every
+//           width from min_width to its full width gives the same image
+//           as seam_carve_width.
+template <typename Img>
+static void check_retarget_matches_carving(const Img *img, int min_width) {
+  SeamIndexMap map;
+  SeamIndexMap_init(&map, img, min_width);
+  for (int width = min_width; width <= Image_width(img); ++width) {
+    Img expected = *img;
+    seam_carve_width(&expected, width);
+    Img retargeted;
+    SeamIndexMap_retarget(&map, img, &retargeted, width);
+    ASSERT_EQUAL(Image_width(&retargeted), width);
+    ASSERT_EQUAL(Image_height(&retargeted), Image_height(img));
+    for (int r = 0; r < Image_height(img); ++r) {
+      for (int c = 0; c < width; ++c) {
+        ASSERT_TRUE(Pixel_equal(Image_get_pixel(&retargeted, r, c),
+                                Image_get_pixel(&expected, r, c)));
+      }
+    }
+  }
+}
+
+// Retargets random images, and an image of only 0 and 255 whose seams
+// tie often, to every width the map covers, as Image and PackedImage
+TEST(test_seam_index_map_matches_carving)
+{
+  unsigned seed = 12;
+  int sizes[][3] = { { 1, 4, 1 }, { 6, 5, 1 }, { 19, 11, 3 }, { 30, 8, 12 } };
+  for (auto &size : sizes) {
+    Image img;
+    random_image(&img, size[0], size[1], &seed);
+    for (int extremes = 0; extremes < 2; ++extremes) {
+      if (extremes) {
+        round_to_extremes(&img);
+      }
+      check_retarget_matches_carving(&img, size[2]);
+      PackedImage packed;
+      Image_init(&packed, &img);
+      check_retarget_matches_carving(&packed, size[2]);
+    }
+  }
+}
+
+// REQUIRES: the file named from exists
+// MODIFIES: the file named to
+// EFFECTS:  Copies all but the last byte of one file to the other.
+static void copy_truncated(const string &from, const string &to) {
+  ifstream input(from, ios::binary);
+  vector<char> bytes((istreambuf_iterator<char>(input)),
+                     istreambuf_iterator<char>());
+  ofstream output(to, ios::binary);
+  output.write(bytes.data(), bytes.size() - 1);
+}
+
+// Writes a SeamIndexMap to a sidecar file and reads it back, then checks
+// that files for another image, with a different hash or a different
+// width, and a truncated file are all rejected
+TEST(test_seam_index_sidecar_round_trip)
+{
+  unsigned seed = 13;
+  Image img;
+  random_image(&img, 23, 9, &seed);
+  SeamIndexMap map;
+  SeamIndexMap_init(&map, &img, 4);
+  SeamIndexHeader header = { 23, 9, Image_content_hash(&img) };
+  const string filename = "seam_index_test.out.seams";
+  ASSERT_TRUE(SeamIndexMap_write(&map, header.hash, filename));
+
+  SeamIndexMap read;
+  ASSERT_TRUE(SeamIndexMap_read(&read, filename, header));
+  ASSERT_EQUAL(read.min_width, 4);
+  ASSERT_TRUE(same_elements(&read.removed_at, &map.removed_at));
+
+  SeamIndexHeader other_hash = header;
+  ++other_hash.hash;
+  ASSERT_FALSE(SeamIndexMap_read(&read, filename, other_hash));
+  SeamIndexHeader narrower = header;
+  --narrower.width;
+  ASSERT_FALSE(SeamIndexMap_read(&read, filename, narrower));
+
+  const string truncated = "seam_index_truncated.out.seams";
+  copy_truncated(filename, truncated);
+  ASSERT_FALSE(SeamIndexMap_read(&read, truncated, header));
+  remove(filename.c_str());
+  remove(truncated.c_str());
+  ASSERT_FALSE(SeamIndexMap_read(&read, filename, header));
+}
+
+// The rectangle of a 30x20 buffer that the view tests work on: its
+// rows are wider than the view, and the view starts inside a row.
+static const int VIEW_LEFT = 3;
+static const int VIEW_TOP = 2;
+static const int VIEW_WIDTH = 21;
+static const int VIEW_HEIGHT = 15;
+static const int BUFFER_WIDTH = 30;
+static const int BUFFER_HEIGHT = 20;
+
+// EFFECTS:  Returns whether the given position of the 30x20 buffer lies
+//           in the view tests' rectangle.
+static bool in_view_rectangle(int row, int column) {
+  return VIEW_TOP <= row && row < VIEW_TOP + VIEW_HEIGHT &&
+         VIEW_LEFT <= column && column < VIEW_LEFT + VIEW_WIDTH;
+}
+
+// REQUIRES: buffer holds BUFFER_HEIGHT rows of BUFFER_WIDTH elements
+// MODIFIES: *view
+// EFFECTS:  Initializes view over the view tests' rectangle of buffer.
+template <typename T>
+static void view_rectangle(MatrixView<T> *view, vector<T> *buffer) {
+  MatrixView_init(view, &(*buffer)[VIEW_TOP * BUFFER_WIDTH + VIEW_LEFT],
+                  { VIEW_WIDTH, VIEW_HEIGHT, BUFFER_WIDTH });
+}
+
+// REQUIRES: buffer points to a valid BUFFER_WIDTH x BUFFER_HEIGHT image
+// MODIFIES: *view, *copy
+// EFFECTS:  Initializes view over the view tests' rectangle of buffer,
+//           and copy to a PackedImage of the same pixels.
+static void view_image_rectangle(ImageView *view, PackedImage *buffer,
+                                 PackedImage *copy) {
+  int first = VIEW_TOP * BUFFER_WIDTH + VIEW_LEFT;
+  ImageView_init(view, &buffer->data[3 * first],
+                 { VIEW_WIDTH, VIEW_HEIGHT, 3 * BUFFER_WIDTH });
+  Image_init(copy, VIEW_WIDTH, VIEW_HEIGHT);
+  for (int r = 0; r < VIEW_HEIGHT; ++r) {
+    for (int c = 0; c < VIEW_WIDTH; ++c) {
+      Image_set_pixel(copy, r, c, Image_get_pixel(view, r, c));
+    }
+  }
+}
+
+// REQUIRES: view was initialized by view_rectangle(view, &buffer)
+//           mat points to a valid Matrix
+// EFFECTS:  Returns whether the view holds the same elements as mat and
+//           every element of buffer outside the view is still sentinel.
+template <typename T, typename M>
+static bool view_matches(const MatrixView<T> *view, const M *mat,
+                         const vector<T> &buffer, T sentinel) {
+  for (int r = 0; r < BUFFER_HEIGHT; ++r) {
+    for (int c = 0; c < BUFFER_WIDTH; ++c) {
+      if (!in_view_rectangle(r, c) &&
+          buffer[r * BUFFER_WIDTH + c] != sentinel) {
+        return false;
+      }
+    }
+  }
+  if (Matrix_width(view) != Matrix_width(mat) ||
+      Matrix_height(view) != Matrix_height(mat)) {
+    return false;
+  }
+  for (int r = 0; r < Matrix_height(mat); ++r) {
+    RowSpan<T> row = Matrix_row(view, r);
+    if (!equal(row.begin(), row.end(), Matrix_row(mat, r).begin())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Carves an ImageView over a rectangle of a larger buffer in place and
+// compares it with carving the same pixels as a PackedImage. No byte of
+// the buffer outside the rectangle may change.
+TEST(test_image_view_carving)
+{
+  unsigned seed = 15;
+  Image img;
+  random_image(&img, BUFFER_WIDTH, BUFFER_HEIGHT, &seed);
+  PackedImage buffer;
+  Image_init(&buffer, &img);
+  PackedImage original = buffer;
+  ImageView view;
+  PackedImage expected;
+  view_image_rectangle(&view, &buffer, &expected);
+
+  for (int width : { 20, 12, 1 }) {
+    seam_carve_width(&view, width);
+    seam_carve_width(&expected, width);
+    ASSERT_EQUAL(Image_width(&view), width);
+    ASSERT_EQUAL(Image_height(&view), VIEW_HEIGHT);
+    for (int r = 0; r < VIEW_HEIGHT; ++r) {
+      for (int c = 0; c < width; ++c) {
+        ASSERT_TRUE(Pixel_equal(Image_get_pixel(&view, r, c),
+                                Image_get_pixel(&expected, r, c)));
+      }
+    }
+    for (int r = 0; r < BUFFER_HEIGHT; ++r) {
+      for (int c = 0; c < BUFFER_WIDTH; ++c) {
+        if (!in_view_rectangle(r, c)) {
+          ASSERT_TRUE(Pixel_equal(Image_get_pixel(&buffer, r, c),
+                                  Image_get_pixel(&original, r, c)));
+        }
+      }
+    }
+  }
+}
+
+// Computes the energy and vertical cost matrices of an ImageView into
+// MatrixViews over rectangles of larger buffers, with both element
+// types, and compares them with the Matrix results for a PackedImage of
+// the same pixels. The buffers outside the views must keep their
+// sentinel values.
+TEST(test_matrix_view_energy_and_cost)
+{
+  unsigned seed = 16;
+  Image img;
+  random_image(&img, BUFFER_WIDTH, BUFFER_HEIGHT, &seed);
+  PackedImage pixels;
+  Image_init(&pixels, &img);
+  ImageView view;
+  PackedImage packed;
+  view_image_rectangle(&view, &pixels, &packed);
+  const int cells = BUFFER_WIDTH * BUFFER_HEIGHT;
+
+  Matrix energy;
+  compute_energy_matrix(&packed, &energy);
+  vector<int> energy_buffer(cells, -7);
+  MatrixView<int> energy_view;
+  view_rectangle(&energy_view, &energy_buffer);
+  compute_energy_matrix(&view, &energy_view);
+  ASSERT_TRUE(view_matches(&energy_view, &energy, energy_buffer, -7));
+
+  Matrix cost;
+  compute_vertical_cost_matrix(&energy, &cost);
+  vector<int> cost_buffer(cells, -7);
+  MatrixView<int> cost_view;
+  view_rectangle(&cost_view, &cost_buffer);
+  const int *energy_data = energy_view.data;
+  MatrixView<const int> const_energy;
+  MatrixView_init(&const_energy, energy_data,
+                  { VIEW_WIDTH, VIEW_HEIGHT, BUFFER_WIDTH });
+  compute_vertical_cost_matrix(&const_energy, &cost_view);
+  ASSERT_TRUE(view_matches(&cost_view, &cost, cost_buffer, -7));
+
+  Matrix16 energy16;
+  compute_energy_matrix(&packed, &energy16);
+  vector<uint16_t> energy16_buffer(cells, 54321);
+  MatrixView<uint16_t> energy16_view;
+  view_rectangle(&energy16_view, &energy16_buffer);
+  compute_energy_matrix(&view, &energy16_view);
+  ASSERT_TRUE(view_matches(&energy16_view, &energy16, energy16_buffer,
+                           (uint16_t)54321));
+
+  Matrix32 cost32;
+  compute_vertical_cost_matrix(&energy16, &cost32);
+  vector<uint32_t> cost32_buffer(cells, 987654321);
+  MatrixView<uint32_t> cost32_view;
+  view_rectangle(&cost32_view, &cost32_buffer);
+  compute_vertical_cost_matrix(&energy16_view, &cost32_view);
+  ASSERT_TRUE(view_matches(&cost32_view, &cost32, cost32_buffer,
+                           987654321u));
+}
+
+TEST_MAIN() // Do NOT put a semicolon here
@@ -0,0 +1,298 @@
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "qoi.hpp"
+#include "mapped_file.hpp"
+
+using namespace std;
+
+static const unsigned char MAGIC[4] = { 'q', 'o', 'i', 'f' };
+static const int HEADER_SIZE = 14;
+static const unsigned char END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+// Chunk tags. The 2-bit tags are in the top bits of the first byte;
+// OP_RGB and OP_RGBA are full bytes that take precedence over OP_RUN.
+static const unsigned char OP_INDEX = 0x00;
+static const unsigned char OP_DIFF = 0x40;
+static const unsigned char OP_LUMA = 0x80;
+static const unsigned char OP_RUN = 0xc0;
+static const unsigned char OP_RGB = 0xfe;
+static const unsigned char OP_RGBA = 0xff;
+static const unsigned char OP_MASK = 0xc0;
+
+static const int INDEX_SIZE = 64;
+static const int MAX_RUN = 62;
+
+// Largest image read, as in the reference implementation, so that a
+// corrupt header cannot ask for gigabytes of memory.
+static const long long MAX_PIXELS = 400000000;
+
+// A pixel as the format sees it, with an alpha channel.
+struct QoiPixel {
+  unsigned char r;
+  unsigned char g;
+  unsigned char b;
+  unsigned char a;
+};
+
+static bool QoiPixel_equal(QoiPixel first, QoiPixel second) {
+  return first.r == second.r && first.g == second.g &&
+         first.b == second.b && first.a == second.a;
+}
+
+// EFFECTS:  Returns the slot of px in the table of recently seen pixels.
+static int QoiPixel_hash(QoiPixel px) {
+  return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % INDEX_SIZE;
+}
+
+static void put_u32_be(unsigned char *out, uint32_t value) {
+  for (int b = 0; b < 4; ++b) {
+    out[b] = (value >> (8 * (3 - b))) & 0xff;
+  }
+}
+
+static uint32_t get_u32_be(const unsigned char *in) {
+  uint32_t value = 0;
+  for (int b = 0; b < 4; ++b) {
+    value = (value << 8) | in[b];
+  }
+  return value;
+}
+
+// EFFECTS: Returns whether or not filename ends with .qoi, ignoring
+//          capitalization.
+bool has_qoi_extension(const string &filename) {
+  size_t dot = filename.rfind('.');
+  if (dot == string::npos) {
+    return false;
+  }
+  string extension = filename.substr(dot + 1);
+  for (auto &ch : extension) {
+    ch = tolower(static_cast<unsigned char>(ch));
+  }
+  return extension == "qoi";
+}
+
+// REQUIRES: out has room for 5 bytes
+//           px differs from prev
+// MODIFIES: out, index
+// EFFECTS:  Writes the shortest chunk that encodes px following prev,
+//           updating the table of recently seen pixels, and returns the
+//           end of the chunk.
+static unsigned char *encode_pixel(unsigned char *out, QoiPixel px,
+                                   QoiPixel prev, QoiPixel *index) {
+  int slot = QoiPixel_hash(px);
+  if (QoiPixel_equal(index[slot], px)) {
+    *out++ = OP_INDEX | slot;
+    return out;
+  }
+  index[slot] = px;
+  if (px.a != prev.a) {
+    *out++ = OP_RGBA;
+    *out++ = px.r;
+    *out++ = px.g;
+    *out++ = px.b;
+    *out++ = px.a;
+    return out;
+  }
+  // Differences wrap around, so 0 follows 255 with a difference of 1.
+  int dr = static_cast<int8_t>(px.r - prev.r);
+  int dg = static_cast<int8_t>(px.g - prev.g);
+  int db = static_cast<int8_t>(px.b - prev.b);
+  int dr_dg = dr - dg;
+  int db_dg = db - dg;
+  if (-2 <= dr && dr <= 1 && -2 <= dg && dg <= 1 && -2 <= db && db <= 1) {
+    *out++ = OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+  } else if (-32 <= dg && dg <= 31 && -8 <= dr_dg && dr_dg <= 7 &&
+             -8 <= db_dg && db_dg <= 7) {
+    *out++ = OP_LUMA | (dg + 32);
+    *out++ = (dr_dg + 8) << 4 | (db_dg + 8);
+  } else {
+    *out++ = OP_RGB;
+    *out++ = px.r;
+    *out++ = px.g;
+    *out++ = px.b;
+  }
+  return out;
+}
+
+// REQUIRES: img points to a valid Image
+//           out points to a vector
+// MODIFIES: *out
+// EFFECTS:  Replaces the contents of out with the image in QOI format.
+// NOTE:     The pixels are read straight from the rows of the channel
+//           matrices.
+void qoi_encode(const Image *img, vector<unsigned char> *out) {
+  int width = Image_width(img);
+  int height = Image_height(img);
+  // No chunk for a single pixel is longer than 4 bytes without alpha.
+  long long worst = HEADER_SIZE + 4LL * width * height + sizeof END_MARKER;
+  out->resize(worst);
+  unsigned char *next = out->data();
+  memcpy(next, MAGIC, sizeof MAGIC);
+  put_u32_be(next + 4, width);
+  put_u32_be(next + 8, height);
+  next[12] = 3; // channels
+  next[13] = 0; // sRGB with linear alpha
+  next += HEADER_SIZE;
+
+  QoiPixel index[INDEX_SIZE] = {};
+  QoiPixel prev = { 0, 0, 0, 255 };
+  int run = 0;
+  for (int row = 0; row < height; ++row) {
+    ImageRow<const uint8_t> pixels = Image_row(img, row);
+    for (int column = 0; column < width; ++column) {
+      QoiPixel px = { pixels.red[column], pixels.green[column],
+                      pixels.blue[column], 255 };
+      if (QoiPixel_equal(px, prev)) {
+        if (++run == MAX_RUN) {
+          *next++ = OP_RUN | (run - 1);
+          run = 0;
+        }
+        continue;
+      }
+      if (run > 0) {
+        *next++ = OP_RUN | (run - 1);
+        run = 0;
+      }
+      next = encode_pixel(next, px, prev, index);
+      prev = px;
+    }
+  }
+  if (run > 0) {
+    *next++ = OP_RUN | (run - 1);
+  }
+  memcpy(next, END_MARKER, sizeof END_MARKER);
+  next += sizeof END_MARKER;
+  out->resize(next - out->data());
+}
+
+// REQUIRES: *in < end
+// MODIFIES: *in, *px, index
+// EFFECTS:  Decodes the chunk at *in into *px, which holds the previous
+//           pixel, and advances *in past it. Returns how many more
+//           pixels repeat px, or -1 if the chunk runs past end.
+static int decode_chunk(const unsigned char **in, const unsigned char *end,
+                        QoiPixel *px, QoiPixel *index) {
+  const unsigned char *p = *in;
+  unsigned char op = *p++;
+  int run = 0;
+  if (op == OP_RGB || op == OP_RGBA) {
+    int length = op == OP_RGB ? 3 : 4;
+    if (end - p < length) {
+      return -1;
+    }
+    px->r = p[0];
+    px->g = p[1];
+    px->b = p[2];
+    if (op == OP_RGBA) {
+      px->a = p[3];
+    }
+    p += length;
+  } else if ((op & OP_MASK) == OP_INDEX) {
+    *px = index[op];
+  } else if ((op & OP_MASK) == OP_DIFF) {
+    px->r += ((op >> 4) & 3) - 2;
+    px->g += ((op >> 2) & 3) - 2;
+    px->b += (op & 3) - 2;
+  } else if ((op & OP_MASK) == OP_LUMA) {
+    if (p == end) {
+      return -1;
+    }
+    int dg = (op & 0x3f) - 32;
+    unsigned char second = *p++;
+    px->r += dg - 8 + (second >> 4);
+    px->g += dg;
+    px->b += dg - 8 + (second & 0x0f);
+  } else {
+    run = op & 0x3f;
+  }
+  index[QoiPixel_hash(*px)] = *px;
+  *in = p;
+  return run;
+}
+
+// REQUIRES: img points to an Image
+//           data points to size bytes
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image from the QOI data. Returns false,
+//           leaving img unspecified, if the data is not a valid QOI
+//           image.
+// NOTE:     The pixels are written straight into the rows of the
+//           channel matrices.
+bool qoi_decode(Image *img, const unsigned char *data, size_t size) {
+  if (size < HEADER_SIZE + sizeof END_MARKER ||
+      memcmp(data, MAGIC, sizeof MAGIC) != 0) {
+    return false;
+  }
+  uint32_t width = get_u32_be(data + 4);
+  uint32_t height = get_u32_be(data + 8);
+  int channels = data[12];
+  int colorspace = data[13];
+  if (width == 0 || height == 0 || width > INT_MAX || height > INT_MAX ||
+      (long long)width * height > MAX_PIXELS ||
+      channels < 3 || channels > 4 || colorspace > 1) {
+    return false;
+  }
+  Image_init(img, width, height);
+
+  const unsigned char *in = data + HEADER_SIZE;
+  const unsigned char *end = data + size - sizeof END_MARKER;
+  QoiPixel index[INDEX_SIZE] = {};
+  QoiPixel px = { 0, 0, 0, 255 };
+  int run = 0;
+  for (int row = 0; row < (int)height; ++row) {
+    ImageRow<uint8_t> pixels = Image_row(img, row);
+    for (int column = 0; column < (int)width; ++column) {
+      if (run > 0) {
+        --run;
+      } else if (in == end ||
+                 (run = decode_chunk(&in, end, &px, index)) < 0) {
+        return false;
+      }
+      pixels.red[column] = px.r;
+      pixels.green[column] = px.g;
+      pixels.blue[column] = px.b;
+    }
+  }
+  return true;
+}
+
+// REQUIRES: img points to an Image
+// MODIFIES: *img, cout
+// EFFECTS:  Reads the QOI file with the given name into the Image.
+//           Returns whether or not the file was successfully read.
+bool read_qoi(Image *img, const string &filename) {
+  MappedFile file;
+  if (!MappedFile_open(&file, filename)) {
+    cout << "Failed to open " << filename << " for reading" << endl;
+    return false;
+  }
+  bool ok = qoi_decode(img, file.data, file.size);
+  MappedFile_close(&file);
+  if (!ok) {
+    cout << "Failed to read QOI image from " << filename << endl;
+  }
+  return ok;
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Image into the file of the given name in QOI
+//           format. Returns whether or not the file was successfully
+//           written.
+bool write_qoi(const Image *img, const string &filename) {
+  ofstream output(filename, ios::out | ios::binary);
+  if (!output.is_open()) {
+    cout << "Failed to open " << filename << " for writing" << endl;
+    return false;
+  }
+  vector<unsigned char> encoded;
+  qoi_encode(img, &encoded);
+  output.write(reinterpret_cast<const char *>(encoded.data()),
+               encoded.size());
+  return output.good();
+}
@@ -0,0 +1,57 @@
+#ifndef QOI_HPP
+#define QOI_HPP
+
+/* qoi.hpp
+ *
+ * Reads and writes Images in the QOI ("Quite OK Image") format, a
+ * lossless format that needs no external library and encodes and
+ * decodes in a single pass over the pixels, which makes it a good
+ * format for intermediate files. See https://qoiformat.org for the
+ * specification.
+ *
+ * The file is a 14-byte header
+ *   "qoif", width (u32), height (u32), channels (u8), colorspace (u8)
+ * with the integers big-endian, followed by a stream of chunks, each
+ * describing one pixel or a run of pixels in row-major order relative
+ * to the pixel before it, and ends with seven 0 bytes and a 1 byte.
+ * Images are written with 3 channels; files with 4 are read with the
+ * alpha channel ignored.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Image.hpp"
+
+// EFFECTS: Returns whether or not filename ends with .qoi, ignoring
+//          capitalization.
+bool has_qoi_extension(const std::string &filename);
+
+// REQUIRES: img points to a valid Image
+//           out points to a vector
+// MODIFIES: *out
+// EFFECTS:  Replaces the contents of out with the image in QOI format.
+void qoi_encode(const Image *img, std::vector<unsigned char> *out);
+
+// REQUIRES: img points to an Image
+//           data points to size bytes
+// MODIFIES: *img
+// EFFECTS:  Initializes the Image from the QOI data. Returns false,
+//           leaving img unspecified, if the data is not a valid QOI
+//           image.
+bool qoi_decode(Image *img, const unsigned char *data, std::size_t size);
+
+// REQUIRES: img points to an Image
+// MODIFIES: *img, cout
+// EFFECTS:  Reads the QOI file with the given name into the Image.
+//           Returns whether or not the file was successfully read.
+bool read_qoi(Image *img, const std::string &filename);
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Image into the file of the given name in QOI
+//           format. Returns whether or not the file was successfully
+//           written.
+bool write_qoi(const Image *img, const std::string &filename);
+
+#endif // QOI_HPP
@@ -1,56 +1,338 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <cstdlib> 
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
 #include "Image.hpp"
+#include "jpeg.hpp"
+#include "qoi.hpp"
 #include "processing.hpp"
+#include "seam_index.hpp"
 
 using namespace std;
 
 static void print_usage_and_return_nonzero() {
-  cout << "Usage: resize.exe IN_FILENAME OUT_FILENAME WIDTH [HEIGHT]\n"
-       << "WIDTH and HEIGHT must be less than or equal to original" << endl;
+  cout << "Usage: resize.exe [OPTIONS] IN_FILENAME OUT_FILENAME WIDTH [HEIGHT]\n"
+       << "       resize.exe [OPTIONS] IN_FILENAME SIZE:OUT_FILENAME...\n"
+       << "where SIZE is WIDTH or WIDTHxHEIGHT, e.g. 480x320:small.ppm.\n"
+       << "The second form writes one file per target from a single carving\n"
+       << "run, and is used whenever every argument after IN_FILENAME is a\n"
+       << "SIZE:OUT_FILENAME target. A missing HEIGHT keeps the original.\n"
+       << "WIDTH and HEIGHT must be less than or equal to original\n"
+       << "Options:\n"
+       << "  --save-seams FILE  record the order of the removed vertical seams\n"
+       << "  --load-seams FILE  reuse seams recorded by --save-seams\n"
+       << "  --format P3|P6     write ASCII (default) or binary PPM output\n"
+       << "The PPM input format is read from its header. Files ending in\n"
+       << ".jpg or .jpeg are read and written as JPEG instead. A JPEG input\n"
+       << "is decoded at 1/2, 1/4 or 1/8 size if every target gives a HEIGHT\n"
+       << "and the image stays at least twice as large as each. Files ending\n"
+       << "in .qoi are read and written as lossless QOI." << endl;
 }
 
-int main(int argc, char *argv[]) {
-    if (argc != 4 && argc != 5) {
-        print_usage_and_return_nonzero();
-        return 1;
+// One output of a run: the file to write and the size to carve to.
+// height is 0 until the input has been read if it was not given.
+struct Target {
+    string filename;
+    int width;
+    int height;
+};
+
+// A JPEG input may be decoded at 1/2, 1/4 or 1/8 size as long as it stays
+// this many times larger than every target in both dimensions, which
+// leaves room for the carving to choose what to remove.
+const int PRESCALE_SLACK = 2;
+
+// EFFECTS: Returns whether arg is a non-empty string of digits.
+static bool is_number(const string &arg) {
+    return !arg.empty() &&
+           arg.find_first_not_of("0123456789") == string::npos;
+}
+
+// REQUIRES: img points to a valid Image whose width is target.width
+// MODIFIES: *img, the file named by target.filename, cout
+// EFFECTS:  Carves the image to target.height and writes it out, as a
+//           JPEG or QOI image if the filename says so, otherwise as a
+//           binary PPM if binary is true and an ASCII one if not.
+//           Returns whether the file was successfully written.
+static bool write_target(Image *img, const Target &target, bool binary) {
+    seam_carve_height(img, target.height);
+    if (has_jpeg_extension(target.filename)) {
+        return write_jpeg(img, target.filename, true);
+    }
+    if (has_qoi_extension(target.filename)) {
+        return write_qoi(img, target.filename);
     }
+    ofstream output(target.filename,
+                    binary ? ios::out | ios::binary : ios::out);
+    if (!output.is_open()) {
+        cout << "Error opening file: " << target.filename << endl;
+        return false;
+    }
+    if (binary) {
+        Image_print_binary(img, output);
+    } else {
+        Image_print(img, output);
+    }
+    return true;
+}
 
-    string in_filename = argv[1];
-    string out_filename = argv[2];
-    int new_width = atoi(argv[3]);
+// The options given before IN_FILENAME.
+struct Options {
+    string save_seams;
+    string load_seams;
+    bool binary;
+};
 
-    ifstream input(in_filename);
-    if (!input.is_open()) {
-        cout << "Error opening file: " << in_filename << endl;
-        return 1;
+// MODIFIES: *options
+// EFFECTS:  Reads the options at the start of argv into options and
+//           returns the index of the first argument after them, or -1 if
+//           an option is not recognized.
+static int parse_options(int argc, char *argv[], Options *options) {
+    options->binary = false;
+    int arg = 1;
+    for (; arg + 1 < argc && string(argv[arg]).rfind("--", 0) == 0; arg += 2) {
+        string option = argv[arg];
+        string value = argv[arg + 1];
+        if (option == "--save-seams") {
+            options->save_seams = value;
+        } else if (option == "--load-seams") {
+            options->load_seams = value;
+        } else if (option == "--format" && (value == "P3" || value == "P6")) {
+            options->binary = value == "P6";
+        } else {
+            return -1;
+        }
     }
+    return arg;
+}
 
-    Image img;
-    Image_init(&img, input);
-    int orig_width = Image_width(&img);
-    int orig_height = Image_height(&img);
+// MODIFIES: *target
+// EFFECTS:  Reads a target of the form WIDTH:OUT_FILENAME or
+//           WIDTHxHEIGHT:OUT_FILENAME into target, with height 0 if it
+//           is not given. Returns false if arg is not of that form.
+static bool parse_target_spec(const string &arg, Target *target) {
+    size_t colon = arg.find(':');
+    if (colon == string::npos || colon + 1 == arg.size()) {
+        return false;
+    }
+    string size = arg.substr(0, colon);
+    size_t x = size.find('x');
+    string width = size.substr(0, x);
+    string height = x == string::npos ? "" : size.substr(x + 1);
+    if (!is_number(width) || (x != string::npos && !is_number(height))) {
+        return false;
+    }
+    target->filename = arg.substr(colon + 1);
+    target->width = atoi(width.c_str());
+    target->height = height.empty() ? 0 : atoi(height.c_str());
+    return true;
+}
+
+// REQUIRES: args holds the arguments after IN_FILENAME
+// MODIFIES: *targets
+// EFFECTS:  Reads the targets into targets. If every argument is a
+//           SIZE:OUT_FILENAME target, each one is a target; otherwise the
+//           arguments must be OUT_FILENAME WIDTH [HEIGHT]. Returns false
+//           if they are neither.
+static bool parse_targets(const vector<string> &args,
+                          vector<Target> *targets) {
+    targets->clear();
+    for (const string &arg : args) {
+        Target target;
+        if (!parse_target_spec(arg, &target)) {
+            break;
+        }
+        targets->push_back(target);
+    }
+    if (!targets->empty() && targets->size() == args.size()) {
+        return true;
+    }
 
-    int new_height = orig_height;
-    if (argc == 5) {
-        new_height = atoi(argv[4]);
+    targets->clear();
+    if (args.size() < 2 || args.size() > 3 || !is_number(args[1]) ||
+        (args.size() == 3 && !is_number(args[2]))) {
+        return false;
     }
+    int height = args.size() == 3 ? atoi(args[2].c_str()) : 0;
+    targets->push_back({ args[0], atoi(args[1].c_str()), height });
+    return true;
+}
 
-    if (new_width <= 0 || new_width > orig_width || 
-        new_height <= 0 || new_height > orig_height) {
-            print_usage_and_return_nonzero();
-            return 1;
+// MODIFIES: *img, cout
+// EFFECTS:  Reads the input file into img, decoding a JPEG at a reduced
+//           scale if every target gives a height and all of them leave
+//           enough room. Returns whether the file was successfully read.
+static bool read_input(Image *img, const string &filename,
+                       const vector<Target> &targets) {
+    // Prescaling a JPEG input is only possible when every target gives
+    // a height; otherwise the full original height has to be kept.
+    int prescale_width = 0;
+    int prescale_height = 0;
+    for (const Target &target : targets) {
+        if (target.height == 0) {
+            prescale_width = 0;
+            prescale_height = 0;
+            break;
         }
+        prescale_width = max(prescale_width, PRESCALE_SLACK * target.width);
+        prescale_height = max(prescale_height,
+                              PRESCALE_SLACK * target.height);
+    }
 
-    seam_carve(&img, new_width, new_height);
-    ofstream output(out_filename);
-    if (!output.is_open()) {
-        cout << "Error opening file: " << out_filename << endl;
+    if (has_jpeg_extension(filename)) {
+        return read_jpeg(img, filename, prescale_width, prescale_height);
+    }
+    if (has_qoi_extension(filename)) {
+        return read_qoi(img, filename);
+    }
+    if (!Image_read(img, filename)) {
+        cout << "Error opening file: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: *targets
+// EFFECTS:  Gives every target without a height the image's height.
+//           Returns false if a target is larger than the image or empty.
+static bool resolve_targets(vector<Target> *targets, const Image *img) {
+    for (Target &target : *targets) {
+        if (target.height == 0) {
+            target.height = Image_height(img);
+        }
+        if (target.width <= 0 || target.width > Image_width(img) ||
+            target.height <= 0 || target.height > Image_height(img)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// REQUIRES: img points to a valid Image, the input
+//           targets have been resolved for img
+// MODIFIES: *map, the --save-seams file, cout
+// EFFECTS:  Loads the --load-seams file into map, or else records the
+//           seams down to the narrowest target into map and saves them
+//           to the --save-seams file. Returns whether map holds seams.
+static bool load_seam_map(SeamIndexMap *map, const Image *img,
+                          const vector<Target> &targets,
+                          const Options &options) {
+    if (options.save_seams.empty() && options.load_seams.empty()) {
+        return false;
+    }
+    SeamIndexHeader header = { Image_width(img), Image_height(img),
+                               Image_content_hash(img) };
+    if (!options.load_seams.empty() &&
+        SeamIndexMap_read(map, options.load_seams, header)) {
+        return true;
+    }
+    if (options.save_seams.empty()) {
+        return false;
+    }
+    int min_width = Image_width(img);
+    for (const Target &target : targets) {
+        min_width = min(min_width, target.width);
+    }
+    SeamIndexMap_init(map, img, min_width);
+    return SeamIndexMap_write(map, header.hash, options.save_seams);
+}
+
+// The single carving run that every target is a snapshot of. Targets
+// no narrower than the recorded seams reach are cut straight from the
+// map; carving continues from where they leave off, so the results are
+// the same as carving from scratch.
+struct CarvingRun {
+    Image *img;               // the input, carved in place if there is no map
+    const SeamIndexMap *map;  // null if no seams were recorded
+    Image carved;             // the input retargeted to map->min_width
+    Image *work;              // the image being carved
+    SeamCarver carver;
+    bool carver_ready;
+};
+
+// REQUIRES: width is no larger than the widths of earlier snapshots
+// MODIFIES: *run, *snapshot
+// EFFECTS:  Sets snapshot to the input carved to the given width.
+static void CarvingRun_snapshot(CarvingRun *run, int width,
+                                Image *snapshot) {
+    const SeamIndexMap *map = run->map;
+    if (map && width >= map->min_width) {
+        SeamIndexMap_retarget(map, run->img, snapshot, width);
+        return;
+    }
+    if (map && run->work == run->img) {
+        SeamIndexMap_retarget(map, run->img, &run->carved, map->min_width);
+        run->work = &run->carved;
+    }
+    while (Image_width(run->work) > width) {
+        if (!run->carver_ready) {
+            SeamCarver_init(&run->carver, run->work);
+            run->carver_ready = true;
+        }
+        SeamCarver_remove_seam(&run->carver, run->work);
+    }
+    *snapshot = *run->work;
+}
+
+// REQUIRES: img points to a valid Image, the input
+//           targets have been resolved for img
+//           map is null or holds the seams of img
+// MODIFIES: *img, the target files, cout
+// EFFECTS:  Carves the image to each target and writes it out. Returns
+//           whether every file was successfully written.
+static bool carve_targets(Image *img, const vector<Target> &targets,
+                          const SeamIndexMap *map, bool binary) {
+    // Carving to a narrower width only removes more seams from the same
+    // sequence, so the targets are visited from widest to narrowest and
+    // each one is a snapshot of a single carving run. Heights are carved
+    // per target, as seam_carve does after the width.
+    vector<int> order(targets.size());
+    for (size_t t = 0; t < targets.size(); ++t) {
+        order[t] = t;
+    }
+    stable_sort(order.begin(), order.end(), [&targets](int a, int b) {
+        return targets[a].width > targets[b].width;
+    });
+
+    CarvingRun run;
+    run.img = img;
+    run.map = map;
+    run.work = img;
+    run.carver_ready = false;
+    for (int t : order) {
+        Image snapshot;
+        CarvingRun_snapshot(&run, targets[t].width, &snapshot);
+        if (!write_target(&snapshot, targets[t], binary)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    int arg = parse_options(argc, argv, &options);
+    vector<Target> targets;
+    if (arg < 0 || argc - arg < 2 ||
+        !parse_targets(vector<string>(argv + arg + 1, argv + argc),
+                       &targets)) {
+        print_usage_and_return_nonzero();
         return 1;
     }
 
-    Image_print(&img, output);
-    return 0;
-}
\ No newline at end of file
+    Image img;
+    if (!read_input(&img, argv[arg], targets)) {
+        return 1;
+    }
+    if (!resolve_targets(&targets, &img)) {
+        print_usage_and_return_nonzero();
+        return 1;
+    }
+    SeamIndexMap map;
+    bool have_map = load_seam_map(&map, &img, targets, options);
+    return carve_targets(&img, targets, have_map ? &map : nullptr,
+                         options.binary) ? 0 : 1;
+}
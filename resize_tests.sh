@@ -0,0 +1,118 @@
+#!/bin/sh
+# resize_tests.sh
+# Command line tests for resize.exe: both forms of the target grammar,
+# --format, the output formats chosen by file extension, and argument
+# lists that must be rejected with the usage message. Run from the
+# project directory after building resize.exe, e.g. with make test.
+
+failures=0
+
+# EFFECTS: Reports a failed check.
+fail() {
+  echo "FAIL: $1"
+  failures=$((failures + 1))
+}
+
+# EFFECTS: Runs resize.exe with the given arguments and checks that it
+#          succeeds.
+accept() {
+  ./resize.exe "$@" > resize_tests.out.txt || fail "resize.exe $*"
+}
+
+# EFFECTS: Runs resize.exe with the given arguments and checks that it
+#          fails with the usage message and writes no output file.
+reject() {
+  rm -f reject.out.ppm
+  if ./resize.exe "$@" > resize_tests.out.txt; then
+    fail "accepted resize.exe $*"
+  fi
+  grep -q "^Usage:" resize_tests.out.txt || fail "no usage for $*"
+  [ ! -e reject.out.ppm ] || fail "wrote output for $*"
+}
+
+# EFFECTS: Checks that the three header lines of the PPM file are the
+#          given words.
+header() {
+  [ "$(head -n 3 "$1" | tr '\n' ' ')" = "$2 " ] ||
+    fail "$1 does not have the header $2"
+}
+
+# EFFECTS: Checks that the two files are identical.
+same() {
+  cmp -s "$1" "$2" || fail "$1 differs from $2"
+}
+
+# A 6x4 input with distinct pixels, so that carving has seams to choose
+printf 'P3\n6 4\n255\n' > input.out.ppm
+for row in 0 1 2 3; do
+  for column in 0 1 2 3 4 5; do
+    printf '%d %d %d ' $((row * 60)) $((column * 40)) \
+           $(((row * 7 + column * 13) % 256)) >> input.out.ppm
+  done
+  printf '\n' >> input.out.ppm
+done
+
+# IN OUT WIDTH [HEIGHT], and the same targets as SIZE:OUT
+accept input.out.ppm plain.out.ppm 4 3
+header plain.out.ppm "P3 4 3 255"
+accept input.out.ppm 4x3:spec.out.ppm
+same spec.out.ppm plain.out.ppm
+accept input.out.ppm width.out.ppm 5
+header width.out.ppm "P3 5 4 255"
+
+# Several targets from one run match separate runs, in any order
+accept input.out.ppm 5:multi_5.out.ppm 4x3:multi_4x3.out.ppm 6x2:multi_6x2.out.ppm
+same multi_5.out.ppm width.out.ppm
+same multi_4x3.out.ppm plain.out.ppm
+accept input.out.ppm single_6x2.out.ppm 6 2
+same multi_6x2.out.ppm single_6x2.out.ppm
+
+# --format P6 writes binary PPM, which reads back by its header
+accept --format P6 input.out.ppm binary.out.ppm 4 3
+header binary.out.ppm "P6 4 3 255"
+[ "$(wc -c < binary.out.ppm)" -eq $((11 + 3 * 4 * 3)) ] ||
+  fail "binary.out.ppm has the wrong size"
+accept binary.out.ppm from_binary.out.ppm 4 3
+same from_binary.out.ppm plain.out.ppm
+accept --format P3 input.out.ppm 4x3:ascii.out.ppm
+same ascii.out.ppm plain.out.ppm
+
+# .qoi files are written and read as QOI whatever the --format
+accept --format P6 input.out.ppm 4x3:image.out.qoi
+[ "$(head -c 4 image.out.qoi)" = "qoif" ] || fail "image.out.qoi is not QOI"
+accept image.out.qoi from_qoi.out.ppm 4 3
+same from_qoi.out.ppm plain.out.ppm
+
+# .jpg files are written and read as JPEG when built with libjpeg
+if ./resize.exe input.out.ppm 4x3:image.out.jpg > resize_tests.out.txt; then
+  accept image.out.jpg 2x1:from_jpeg.out.ppm
+  header from_jpeg.out.ppm "P3 2 1 255"
+else
+  grep -q "without jpeg support" resize_tests.out.txt ||
+    fail "writing image.out.jpg"
+fi
+
+# Argument lists that match neither form, or targets the input can't meet
+reject
+reject input.out.ppm
+reject input.out.ppm reject.out.ppm
+reject input.out.ppm reject.out.ppm 4 3 2
+reject input.out.ppm reject.out.ppm four
+reject input.out.ppm reject.out.ppm 4 -3
+reject input.out.ppm 4x:reject.out.ppm
+reject input.out.ppm x3:reject.out.ppm
+reject input.out.ppm 4x3:
+reject input.out.ppm 4x3:reject.out.ppm other.out.ppm
+reject input.out.ppm reject.out.ppm 7
+reject input.out.ppm 6x5:reject.out.ppm
+reject input.out.ppm reject.out.ppm 0 3
+reject --format P5 input.out.ppm reject.out.ppm 4
+reject --format input.out.ppm reject.out.ppm 4
+reject --bogus x input.out.ppm reject.out.ppm 4
+
+rm -f *.out.qoi *.out.jpg
+if [ "$failures" -ne 0 ]; then
+  echo "$failures resize.exe check(s) failed"
+  exit 1
+fi
+echo "resize.exe command line tests PASS"
@@ -0,0 +1,298 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "seam_index.hpp"
+#include "mapped_file.hpp"
+
+using namespace std;
+
+static const char MAGIC[4] = { 'S', 'E', 'A', 'M' };
+static const uint32_t VERSION = 1;
+static const int HEADER_SIZE = 32;
+
+// EFFECTS:  Returns the size in bytes of one seam record of an image of
+//           the given height.
+static long long record_size(int height) {
+  return 4 + (height + 2) / 4;
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+  for (int b = 0; b < 4; ++b) {
+    out[b] = (value >> (8 * b)) & 0xff;
+  }
+}
+
+static void put_u64(unsigned char *out, uint64_t value) {
+  for (int b = 0; b < 8; ++b) {
+    out[b] = (value >> (8 * b)) & 0xff;
+  }
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+  uint32_t value = 0;
+  for (int b = 0; b < 4; ++b) {
+    value |= (uint32_t)in[b] << (8 * b);
+  }
+  return value;
+}
+
+static uint64_t get_u64(const unsigned char *in) {
+  uint64_t value = 0;
+  for (int b = 0; b < 8; ++b) {
+    value |= (uint64_t)in[b] << (8 * b);
+  }
+  return value;
+}
+
+// The pixels of each row that have not been removed yet, kept as one
+// Fenwick tree per row. A seam record stores columns of the partly
+// carved image, and the trees convert those to and from columns of the
+// original image in O(log width).
+struct RemainingColumns {
+  int width;
+  int top_bit;          // largest power of two <= width
+  vector<int> tree;     // height trees of width + 1 entries each
+};
+
+// EFFECTS:  Initializes rc with every pixel of every row remaining.
+static void RemainingColumns_init(RemainingColumns *rc, int width,
+                                  int height) {
+  rc->width = width;
+  rc->top_bit = 1;
+  while (rc->top_bit * 2 <= width) {
+    rc->top_bit *= 2;
+  }
+  rc->tree.resize((long long)(width + 1) * height);
+  for (int i = 0; i < height; ++i) {
+    int *tree = rc->tree.data() + (long long)i * (width + 1);
+    tree[0] = 0;
+    // Entry n covers the (n & -n) columns ending at column n - 1.
+    for (int n = 1; n <= width; ++n) {
+      tree[n] = n & -n;
+    }
+  }
+}
+
+// REQUIRES: the pixel at the given original column of row remains
+// EFFECTS:  Returns the pixel's column in the partly carved image.
+static int RemainingColumns_rank(const RemainingColumns *rc, int row,
+                                 int column) {
+  const int *tree = rc->tree.data() + (long long)row * (rc->width + 1);
+  int count = 0;
+  for (int n = column; n > 0; n -= n & -n) {
+    count += tree[n];
+  }
+  return count;
+}
+
+// REQUIRES: 0 <= rank < the number of remaining pixels in row
+// EFFECTS:  Returns the original column of the pixel at column rank of
+//           the partly carved image.
+static int RemainingColumns_select(const RemainingColumns *rc, int row,
+                                   int rank) {
+  const int *tree = rc->tree.data() + (long long)row * (rc->width + 1);
+  // Find the longest prefix of original columns holding at most rank
+  // remaining pixels; the pixel sought is the next one.
+  int pos = 0;
+  for (int step = rc->top_bit; step > 0; step /= 2) {
+    if (pos + step <= rc->width && tree[pos + step] <= rank) {
+      pos += step;
+      rank -= tree[pos];
+    }
+  }
+  return pos;
+}
+
+// REQUIRES: the pixel at the given original column of row remains
+// MODIFIES: *rc
+// EFFECTS:  Marks the pixel as removed.
+static void RemainingColumns_remove(RemainingColumns *rc, int row,
+                                    int column) {
+  int *tree = rc->tree.data() + (long long)row * (rc->width + 1);
+  for (int n = column + 1; n <= rc->width; n += n & -n) {
+    --tree[n];
+  }
+}
+
+// EFFECTS:  Returns hash updated with the given byte (FNV-1a).
+static uint64_t hash_byte(uint64_t hash, unsigned char byte) {
+  return (hash ^ byte) * 1099511628211ull;
+}
+
+// EFFECTS:  Returns hash updated with the bytes of the given row of img,
+//           red, green and blue for each pixel in turn.
+static uint64_t hash_row(uint64_t hash, const Image *img, int row) {
+  ImageRow<const uint8_t> pixels = Image_row(img, row);
+  for (int j = 0; j < Image_width(img); ++j) {
+    hash = hash_byte(hash, pixels.red[j]);
+    hash = hash_byte(hash, pixels.green[j]);
+    hash = hash_byte(hash, pixels.blue[j]);
+  }
+  return hash;
+}
+
+// EFFECTS:  Same as hash_row for an Image.
+static uint64_t hash_row(uint64_t hash, const PackedImage *img, int row) {
+  const uint8_t *pixels = &img->data[3 * (long long)row * img->width];
+  for (int j = 0; j < 3 * img->width; ++j) {
+    hash = hash_byte(hash, pixels[j]);
+  }
+  return hash;
+}
+
+// REQUIRES: img points to a valid Image
+// EFFECTS:  Returns a 64-bit FNV-1a hash of the image's dimensions and
+//           pixels, used to check that a sidecar file belongs to it.
+template <typename Img>
+uint64_t Image_content_hash(const Img *img) {
+  uint64_t hash = 14695981039346656037ull;
+  unsigned char dims[8];
+  put_u32(dims, Image_width(img));
+  put_u32(dims + 4, Image_height(img));
+  for (unsigned char byte : dims) {
+    hash = hash_byte(hash, byte);
+  }
+  for (int i = 0; i < Image_height(img); ++i) {
+    hash = hash_row(hash, img, i);
+  }
+  return hash;
+}
+
+// REQUIRES: map points to a valid SeamIndexMap
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the seams recorded in map to the given file, tagged
+//           with hash. Returns whether the file was successfully written.
+bool SeamIndexMap_write(const SeamIndexMap *map, uint64_t hash,
+                        const string &filename) {
+  int width = Matrix_width(&map->removed_at);
+  int height = Matrix_height(&map->removed_at);
+  int count = width - map->min_width;
+
+  // Original column of the pixel each seam removed from each row.
+  vector<int> removed((long long)count * height);
+  for (int i = 0; i < height; ++i) {
+    RowSpan<const uint32_t> row = Matrix_row(&map->removed_at, i);
+    for (int j = 0; j < width; ++j) {
+      uint32_t k = row[j];
+      if (k != REMOVED_NEVER) {
+        removed[(long long)k * height + i] = j;
+      }
+    }
+  }
+
+  vector<unsigned char> bytes(HEADER_SIZE + count * record_size(height), 0);
+  memcpy(bytes.data(), MAGIC, sizeof MAGIC);
+  put_u32(&bytes[4], VERSION);
+  put_u32(&bytes[8], width);
+  put_u32(&bytes[12], height);
+  put_u32(&bytes[16], count);
+  put_u64(&bytes[24], hash);
+
+  RemainingColumns remaining;
+  RemainingColumns_init(&remaining, width, height);
+  for (int k = 0; k < count; ++k) {
+    unsigned char *record = &bytes[HEADER_SIZE + k * record_size(height)];
+    int prev = 0;
+    for (int i = 0; i < height; ++i) {
+      int original = removed[(long long)k * height + i];
+      int column = RemainingColumns_rank(&remaining, i, original);
+      RemainingColumns_remove(&remaining, i, original);
+      if (i == 0) {
+        put_u32(record, column);
+      } else {
+        int step = column - prev;
+        assert(-1 <= step && step <= 1);
+        record[4 + (i - 1) / 4] |= (step + 1) << (2 * ((i - 1) % 4));
+      }
+      prev = column;
+    }
+  }
+
+  ofstream output(filename, ios::binary);
+  if (!output.is_open()) {
+    cout << "Error opening file: " << filename << endl;
+    return false;
+  }
+  output.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  return static_cast<bool>(output);
+}
+
+// REQUIRES: data points to size bytes
+// MODIFIES: *map
+// EFFECTS:  Rebuilds map from the sidecar contents in data, as described
+//           for SeamIndexMap_read.
+static bool read_seams(SeamIndexMap *map, const unsigned char *data,
+                       size_t size, const SeamIndexHeader &expected) {
+  if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof MAGIC) != 0 ||
+      get_u32(data + 4) != VERSION) {
+    return false;
+  }
+  int width = expected.width;
+  int height = expected.height;
+  if (get_u32(data + 8) != (uint32_t)width ||
+      get_u32(data + 12) != (uint32_t)height ||
+      get_u64(data + 24) != expected.hash) {
+    return false;
+  }
+  uint32_t count = get_u32(data + 16);
+  if (count >= (uint32_t)width ||
+      size != HEADER_SIZE + count * record_size(height)) {
+    return false;
+  }
+
+  map->min_width = width - count;
+  Matrix_init(&map->removed_at, width, height);
+  Matrix_fill(&map->removed_at, REMOVED_NEVER);
+  RemainingColumns remaining;
+  RemainingColumns_init(&remaining, width, height);
+  for (uint32_t k = 0; k < count; ++k) {
+    const unsigned char *record = data + HEADER_SIZE + k * record_size(height);
+    uint32_t first = get_u32(record);
+    if (first >= width - k) {
+      return false;
+    }
+    int column = first;
+    for (int i = 0; i < height; ++i) {
+      if (i > 0) {
+        int code = (record[4 + (i - 1) / 4] >> (2 * ((i - 1) % 4))) & 3;
+        if (code == 3) {
+          return false;
+        }
+        column += code - 1;
+        if (column < 0 || column >= (int)(width - k)) {
+          return false;
+        }
+      }
+      int original = RemainingColumns_select(&remaining, i, column);
+      Matrix_row(&map->removed_at, i)[original] = k;
+      RemainingColumns_remove(&remaining, i, original);
+    }
+  }
+  return true;
+}
+
+// REQUIRES: map points to a SeamIndexMap
+// MODIFIES: *map, cout
+// EFFECTS:  Maps the given sidecar file into memory and rebuilds from it
+//           the SeamIndexMap of the image described by expected. Returns
+//           false, leaving map unspecified, if the file cannot be read,
+//           is malformed, or belongs to another image.
+bool SeamIndexMap_read(SeamIndexMap *map, const string &filename,
+                       const SeamIndexHeader &expected) {
+  MappedFile file;
+  if (!MappedFile_open(&file, filename)) {
+    cout << "Error opening file: " << filename << endl;
+    return false;
+  }
+  bool ok = read_seams(map, file.data, file.size, expected);
+  MappedFile_close(&file);
+  if (!ok) {
+    cout << filename << " is not a seam index for this image" << endl;
+  }
+  return ok;
+}
+
+template uint64_t Image_content_hash(const Image*);
+template uint64_t Image_content_hash(const PackedImage*);
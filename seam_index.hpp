@@ -0,0 +1,55 @@
+#ifndef SEAM_INDEX_HPP
+#define SEAM_INDEX_HPP
+
+/* seam_index.hpp
+ *
+ * Reads and writes SeamIndexMaps as sidecar files, so that the seam
+ * order computed for an image can be stored next to it and reused by
+ * later runs without recomputing any energy or cost matrices.
+ *
+ * The file is little-endian. A 32-byte header holds
+ *   "SEAM", version (u32), width (u32), height (u32),
+ *   seam count (u32), 0 (u32), content hash (u64)
+ * and is followed by one fixed-size record per seam, in removal order.
+ * A record holds the seam's column in row 0 of the image as it was when
+ * the seam was removed (u32), then 2 bits per following row giving the
+ * step from the row above: 0 for -1, 1 for 0 and 2 for +1, packed from
+ * the low bits of each byte.
+ */
+
+#include <cstdint>
+#include <string>
+#include "Image.hpp"
+#include "processing.hpp"
+
+// The header fields that tie a sidecar file to an image: the size of the
+// image and a hash of its contents.
+struct SeamIndexHeader {
+  int width;
+  int height;
+  uint64_t hash;
+};
+
+// REQUIRES: img points to a valid Image
+// EFFECTS:  Returns a 64-bit FNV-1a hash of the image's dimensions and
+//           pixels, used to check that a sidecar file belongs to it.
+template <typename Img>
+uint64_t Image_content_hash(const Img *img);
+
+// REQUIRES: map points to a valid SeamIndexMap
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the seams recorded in map to the given file, tagged
+//           with hash. Returns whether the file was successfully written.
+bool SeamIndexMap_write(const SeamIndexMap *map, uint64_t hash,
+                        const std::string &filename);
+
+// REQUIRES: map points to a SeamIndexMap
+// MODIFIES: *map, cout
+// EFFECTS:  Maps the given sidecar file into memory and rebuilds from it
+//           the SeamIndexMap of the image described by expected. Returns
+//           false, leaving map unspecified, if the file cannot be read,
+//           is malformed, or belongs to another image.
+bool SeamIndexMap_read(SeamIndexMap *map, const std::string &filename,
+                       const SeamIndexHeader &expected);
+
+#endif // SEAM_INDEX_HPP
@@ -0,0 +1,75 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/* simd.hpp
+ *
+ * Runtime selection of x86 vector instruction sets, shared by the
+ * vectorized kernels in the Matrix and processing modules. Kernels are
+ * compiled per instruction set with __attribute__((target(...))) and
+ * chosen with simd_level(), so the program still runs on any CPU and
+ * builds with the project's ordinary CXXFLAGS. On other compilers or
+ * architectures SIMD_X86 is 0 and only the scalar paths are used.
+ */
+
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+enum SimdLevel { SIMD_NONE, SIMD_SSE41, SIMD_AVX2 };
+
+// EFFECTS:  Returns the best instruction set supported by this CPU.
+inline SimdLevel simd_cpu_level() {
+#if SIMD_X86
+  static const SimdLevel level =
+    __builtin_cpu_supports("avx2") ? SIMD_AVX2 :
+    __builtin_cpu_supports("sse4.1") ? SIMD_SSE41 : SIMD_NONE;
+  return level;
+#else
+  return SIMD_NONE;
+#endif
+}
+
+// EFFECTS:  Returns the highest instruction set the kernels may use,
+//           which can be lowered so that tests reach every kernel.
+inline SimdLevel &simd_level_limit() {
+  static SimdLevel limit = SIMD_AVX2;
+  return limit;
+}
+
+// EFFECTS:  Returns the instruction set the kernels use: the best one
+//           this CPU supports, up to simd_level_limit().
+inline SimdLevel simd_level() {
+  SimdLevel cpu = simd_cpu_level();
+  return cpu < simd_level_limit() ? cpu : simd_level_limit();
+}
+
+#if SIMD_X86
+
+// EFFECTS:  Returns the lane-wise minimum of a and b, comparing lanes as
+//           signed or unsigned 32-bit integers according to the type of
+//           the (unused) third argument.
+__attribute__((target("avx2")))
+inline __m256i min_lanes(__m256i a, __m256i b, const int*) {
+  return _mm256_min_epi32(a, b);
+}
+__attribute__((target("avx2")))
+inline __m256i min_lanes(__m256i a, __m256i b, const uint32_t*) {
+  return _mm256_min_epu32(a, b);
+}
+__attribute__((target("sse4.1")))
+inline __m128i min_lanes(__m128i a, __m128i b, const int*) {
+  return _mm_min_epi32(a, b);
+}
+__attribute__((target("sse4.1")))
+inline __m128i min_lanes(__m128i a, __m128i b, const uint32_t*) {
+  return _mm_min_epu32(a, b);
+}
+
+#endif // SIMD_X86
+
+#endif // SIMD_HPP
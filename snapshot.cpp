@@ -0,0 +1,200 @@
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "snapshot.hpp"
+
+using namespace std;
+
+static const char MAGIC[4] = { 'S', 'N', 'A', 'P' };
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 64;
+static const size_t ROW_ALIGNMENT = 64;
+
+// The header fields after the magic number, in file order.
+struct SnapshotHeader {
+  uint32_t version;
+  uint32_t element;
+  uint32_t planes;
+  uint32_t width;
+  uint32_t height;
+  uint32_t unused;
+  uint64_t stride;
+};
+
+// The SnapshotElement that holds elements of type T.
+template <typename T>
+struct ElementOf;
+template <>
+struct ElementOf<int> {
+  static const SnapshotElement value = SNAPSHOT_INT32;
+};
+template <>
+struct ElementOf<uint8_t> {
+  static const SnapshotElement value = SNAPSHOT_UINT8;
+};
+template <>
+struct ElementOf<uint16_t> {
+  static const SnapshotElement value = SNAPSHOT_UINT16;
+};
+template <>
+struct ElementOf<uint32_t> {
+  static const SnapshotElement value = SNAPSHOT_UINT32;
+};
+
+// EFFECTS:  Returns the size in bytes of the given element type, or 0
+//           if it is not one.
+static size_t element_size(uint32_t element) {
+  switch (element) {
+  case SNAPSHOT_INT32:
+    return sizeof(int32_t);
+  case SNAPSHOT_UINT8:
+    return sizeof(uint8_t);
+  case SNAPSHOT_UINT16:
+    return sizeof(uint16_t);
+  case SNAPSHOT_UINT32:
+    return sizeof(uint32_t);
+  default:
+    return 0;
+  }
+}
+
+// REQUIRES: planes points to count valid Matrices of the same size
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Matrices to the given file as the planes of a
+//           snapshot. Returns whether the file was successfully written.
+template <typename T>
+static bool write_planes(const BasicMatrix<T>* const* planes, int count,
+                         const string& filename) {
+  ofstream output(filename, ios::out | ios::binary);
+  if (!output.is_open()) {
+    cout << "Error opening file: " << filename << endl;
+    return false;
+  }
+  int width = Matrix_width(planes[0]);
+  int height = Matrix_height(planes[0]);
+  size_t row_bytes = width * sizeof(T);
+  size_t stride = (row_bytes + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT *
+                  ROW_ALIGNMENT;
+
+  char header[HEADER_SIZE] = {};
+  SnapshotHeader fields = { VERSION, ElementOf<T>::value, (uint32_t)count,
+                            (uint32_t)width, (uint32_t)height, 0, stride };
+  memcpy(header, MAGIC, sizeof MAGIC);
+  memcpy(header + sizeof MAGIC, &fields, sizeof fields);
+  output.write(header, HEADER_SIZE);
+
+  vector<char> padding(stride - row_bytes);
+  for (int plane = 0; plane < count; ++plane) {
+    for (int row = 0; row < height; ++row) {
+      RowSpan<const T> elements = Matrix_row(planes[plane], row);
+      output.write(reinterpret_cast<const char*>(elements.data), row_bytes);
+      output.write(padding.data(), padding.size());
+    }
+  }
+  return output.good();
+}
+
+// REQUIRES: mat points to a valid Matrix
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Matrix to the given file as a one-plane snapshot.
+//           Returns whether or not the file was successfully written.
+template <typename T>
+bool Matrix_write_snapshot(const BasicMatrix<T>* mat,
+                           const string& filename) {
+  return write_planes(&mat, 1, filename);
+}
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Image to the given file as a three-plane snapshot
+//           of bytes. Returns whether or not the file was successfully
+//           written.
+bool Image_write_snapshot(const Image* img, const string& filename) {
+  const Matrix8* planes[3] = { &img->red_channel, &img->green_channel,
+                               &img->blue_channel };
+  return write_planes(planes, 3, filename);
+}
+
+// EFFECTS:  Returns whether the mapped bytes start with a valid header
+//           for a snapshot that fits in them, filling in fields if so.
+static bool read_header(const unsigned char* data, size_t size,
+                        SnapshotHeader* fields) {
+  if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof MAGIC) != 0) {
+    return false;
+  }
+  memcpy(fields, data + sizeof MAGIC, sizeof *fields);
+  size_t element_bytes = element_size(fields->element);
+  return fields->version == VERSION && element_bytes != 0 &&
+         fields->planes > 0 && fields->planes <= INT_MAX &&
+         fields->width > 0 && fields->width <= INT_MAX &&
+         fields->height > 0 && fields->height <= INT_MAX &&
+         fields->stride % ROW_ALIGNMENT == 0 &&
+         fields->stride >= (uint64_t)fields->width * element_bytes &&
+         (size - HEADER_SIZE) / fields->stride / fields->height >=
+           fields->planes;
+}
+
+// REQUIRES: snap points to a Snapshot
+// MODIFIES: *snap
+// EFFECTS:  Maps the given snapshot file into memory. Returns false,
+//           leaving snap closed, if the file cannot be read or is not a
+//           valid snapshot.
+bool Snapshot_open(Snapshot* snap, const string& filename) {
+  if (!MappedFile_open(&snap->file, filename)) {
+    return false;
+  }
+  SnapshotHeader fields;
+  if (!read_header(snap->file.data, snap->file.size, &fields)) {
+    MappedFile_close(&snap->file);
+    return false;
+  }
+  snap->width = fields.width;
+  snap->height = fields.height;
+  snap->planes = fields.planes;
+  snap->element = static_cast<SnapshotElement>(fields.element);
+  snap->stride = fields.stride;
+  return true;
+}
+
+// REQUIRES: snap points to a Snapshot opened with Snapshot_open
+// MODIFIES: *snap
+// EFFECTS:  Unmaps the file. Views of its planes become invalid.
+void Snapshot_close(Snapshot* snap) {
+  MappedFile_close(&snap->file);
+}
+
+// REQUIRES: snap points to an open Snapshot
+//           view points to a MatrixView
+//           0 <= plane && plane < snap->planes
+// MODIFIES: *view
+// EFFECTS:  Sets view to the given plane of the snapshot, in place in
+//           the mapped file. Returns false, leaving view unchanged, if
+//           the snapshot does not hold elements of type T.
+template <typename T>
+bool Snapshot_view(const Snapshot* snap, int plane,
+                   MatrixView<const T>* view) {
+  if (snap->element != ElementOf<T>::value) {
+    return false;
+  }
+  size_t offset = HEADER_SIZE + (size_t)plane * snap->height * snap->stride;
+  view->width = snap->width;
+  view->height = snap->height;
+  view->stride = snap->stride / sizeof(T);
+  view->data = reinterpret_cast<const T*>(snap->file.data + offset);
+  return true;
+}
+
+// Explicit instantiations for the element types used by the project.
+#define SNAPSHOT_INSTANTIATE(T)                                            \
+  template bool Matrix_write_snapshot(const BasicMatrix<T>*,              \
+                                      const string&);                     \
+  template bool Snapshot_view(const Snapshot*, int, MatrixView<const T>*);
+
+SNAPSHOT_INSTANTIATE(int)
+SNAPSHOT_INSTANTIATE(uint8_t)
+SNAPSHOT_INSTANTIATE(uint16_t)
+SNAPSHOT_INSTANTIATE(uint32_t)
+
+#undef SNAPSHOT_INSTANTIATE
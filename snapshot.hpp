@@ -0,0 +1,86 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+/* snapshot.hpp
+ *
+ * Binary snapshots of Matrices and Images, for caching intermediate
+ * results such as energy maps and for passing images between processes
+ * without formatting or parsing any text. A snapshot is opened by
+ * memory-mapping the file, and its planes are used in place through
+ * read-only MatrixViews.
+ *
+ * A 64-byte header holds
+ *   "SNAP", version (u32), element type (u32), planes (u32),
+ *   width (u32), height (u32), 0 (u32), row stride in bytes (u64)
+ * followed by zeros. The header fields and elements are in the byte
+ * order of the machine that wrote the file; other machines reject it
+ * by its version. The rows follow the header, plane by plane and top
+ * to bottom, each padded with zeros to the stride, a multiple of 64
+ * bytes, so that every row starts on a cache line. A Matrix is one
+ * plane; an Image is three, red, green and blue.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Image.hpp"
+#include "Matrix.hpp"
+#include "mapped_file.hpp"
+
+// The element types a snapshot can hold.
+enum SnapshotElement : uint32_t {
+  SNAPSHOT_INT32 = 1,
+  SNAPSHOT_UINT8 = 2,
+  SNAPSHOT_UINT16 = 3,
+  SNAPSHOT_UINT32 = 4
+};
+
+// An open snapshot file. The planes stay valid until Snapshot_close.
+struct Snapshot {
+  int width;
+  int height;
+  int planes;
+  SnapshotElement element;
+  std::size_t stride; // bytes from one row to the next
+  MappedFile file;
+};
+
+// REQUIRES: mat points to a valid Matrix
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Matrix to the given file as a one-plane snapshot.
+//           Returns whether or not the file was successfully written.
+template <typename T>
+bool Matrix_write_snapshot(const BasicMatrix<T>* mat,
+                           const std::string& filename);
+
+// REQUIRES: img points to a valid Image
+// MODIFIES: the file corresponding to the given filename, cout
+// EFFECTS:  Writes the Image to the given file as a three-plane snapshot
+//           of bytes. Returns whether or not the file was successfully
+//           written.
+bool Image_write_snapshot(const Image* img, const std::string& filename);
+
+// REQUIRES: snap points to a Snapshot
+// MODIFIES: *snap
+// EFFECTS:  Maps the given snapshot file into memory. Returns false,
+//           leaving snap closed, if the file cannot be read or is not a
+//           valid snapshot.
+bool Snapshot_open(Snapshot* snap, const std::string& filename);
+
+// REQUIRES: snap points to a Snapshot opened with Snapshot_open
+// MODIFIES: *snap
+// EFFECTS:  Unmaps the file. Views of its planes become invalid.
+void Snapshot_close(Snapshot* snap);
+
+// REQUIRES: snap points to an open Snapshot
+//           view points to a MatrixView
+//           0 <= plane && plane < snap->planes
+// MODIFIES: *view
+// EFFECTS:  Sets view to the given plane of the snapshot, in place in
+//           the mapped file. Returns false, leaving view unchanged, if
+//           the snapshot does not hold elements of type T.
+template <typename T>
+bool Snapshot_view(const Snapshot* snap, int plane,
+                   MatrixView<const T>* view);
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,81 @@
+#ifndef TEXT_WRITER_HPP
+#define TEXT_WRITER_HPP
+
+/* text_writer.hpp
+ *
+ * Buffered formatting of integers for text printers such as
+ * Matrix_print. Numbers are formatted with std::to_chars into a
+ * large buffer that is handed to the stream in big chunks, instead of
+ * going through operator<< per value and std::endl per row, which
+ * flushes the stream every line. The bytes written are the same.
+ */
+
+#include <charconv>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Size of the buffer, and so of the chunks passed to the stream.
+const std::size_t TEXT_WRITER_CAPACITY = 1 << 16;
+
+// Room reserved for one number and the character after it.
+const std::size_t TEXT_WRITER_MAX_FIELD = 24;
+
+// A buffer in front of an output stream.
+struct TextWriter {
+  std::ostream *os;
+  std::vector<char> buffer;
+  std::size_t used;
+};
+
+// REQUIRES: writer points to a TextWriter
+// MODIFIES: *writer
+// EFFECTS:  Initializes the writer with an empty buffer in front of os.
+inline void TextWriter_init(TextWriter *writer, std::ostream *os) {
+  writer->os = os;
+  writer->buffer.resize(TEXT_WRITER_CAPACITY);
+  writer->used = 0;
+}
+
+// REQUIRES: writer points to a valid TextWriter
+// MODIFIES: *writer, its stream
+// EFFECTS:  Writes out everything buffered so far.
+inline void TextWriter_drain(TextWriter *writer) {
+  writer->os->write(writer->buffer.data(), writer->used);
+  writer->used = 0;
+}
+
+// REQUIRES: writer points to a valid TextWriter
+// MODIFIES: *writer, its stream
+// EFFECTS:  Appends value in decimal followed by the character after.
+template <typename T>
+inline void TextWriter_put(TextWriter *writer, T value, char after) {
+  if (writer->used + TEXT_WRITER_MAX_FIELD > writer->buffer.size()) {
+    TextWriter_drain(writer);
+  }
+  char *out = writer->buffer.data() + writer->used;
+  char *end = std::to_chars(out, out + TEXT_WRITER_MAX_FIELD, value).ptr;
+  *end++ = after;
+  writer->used = end - writer->buffer.data();
+}
+
+// REQUIRES: writer points to a valid TextWriter
+// MODIFIES: *writer, its stream
+// EFFECTS:  Appends a single character.
+inline void TextWriter_put_char(TextWriter *writer, char ch) {
+  if (writer->used == writer->buffer.size()) {
+    TextWriter_drain(writer);
+  }
+  writer->buffer[writer->used++] = ch;
+}
+
+// REQUIRES: writer points to a valid TextWriter
+// MODIFIES: *writer, its stream
+// EFFECTS:  Writes out everything buffered and flushes the stream once,
+//           leaving it as the per-row flushes used to.
+inline void TextWriter_finish(TextWriter *writer) {
+  TextWriter_drain(writer);
+  writer->os->flush();
+}
+
+#endif // TEXT_WRITER_HPP